@@ -0,0 +1,185 @@
+#include "ray_tracer.h"
+#include "benchmark/benchmark.h"
+
+#include <cmath>
+#include <vector>
+
+
+// Microbenchmarks for the hot parts of the render path. Build with
+// 'cmake -Dbench=ON -DCMAKE_BUILD_TYPE=Release' and run ./bench.out.
+// Ray-based benchmarks report a "rays" rate, i.e. rays per second.
+
+static void count_rays(benchmark::State &state, double rays_per_iteration) {
+    state.counters["rays"] = benchmark::Counter(
+        state.iterations() * rays_per_iteration,
+        benchmark::Counter::kIsRate
+    );
+};
+
+// Chapter 3: Matrices
+static void BM_MatrixInverse(benchmark::State &state) {
+    Matrix m = translation_matrix(1, 2, 3) * rotation_y_matrix(0.5) * scaling_matrix(2, 3, 4);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m.inverse());
+    };
+};
+BENCHMARK(BM_MatrixInverse);
+
+static void BM_Matrix4Inverse(benchmark::State &state) {
+    Matrix4 m = translation_matrix(1, 2, 3) * rotation_y_matrix(0.5) * scaling_matrix(2, 3, 4);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m.inverse());
+    };
+};
+BENCHMARK(BM_Matrix4Inverse);
+
+static void BM_MatrixTimesTuple(benchmark::State &state) {
+    Matrix m = translation_matrix(1, 2, 3) * rotation_y_matrix(0.5);
+    Tuple t = point(1, -2, 3);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m * t);
+    };
+};
+BENCHMARK(BM_MatrixTimesTuple);
+
+static void BM_Matrix4TimesTuple(benchmark::State &state) {
+    Matrix4 m = translation_matrix(1, 2, 3) * rotation_y_matrix(0.5);
+    Tuple t = point(1, -2, 3);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m * t);
+    };
+};
+BENCHMARK(BM_Matrix4TimesTuple);
+
+// Chapter 5 & 9: Intersections
+static void BM_SphereLocalIntersect(benchmark::State &state) {
+    Sphere s = Sphere();
+    Ray r = Ray(point(0.2, 0.3, -5), vector(0, 0, 1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(s.local_intersect(r));
+    };
+    count_rays(state, 1);
+};
+BENCHMARK(BM_SphereLocalIntersect);
+
+static void BM_PlaneLocalIntersect(benchmark::State &state) {
+    Plane p = Plane();
+    Ray r = Ray(point(0, 1, 0), vector(0, -1, 0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(p.local_intersect(r));
+    };
+    count_rays(state, 1);
+};
+BENCHMARK(BM_PlaneLocalIntersect);
+
+// Chapter 7: Making a Scene
+static void BM_WorldIntersect(benchmark::State &state) {
+    World w = default_world();
+    Ray r = Ray(point(0, 0, -5), vector(0, 0, 1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(w.intersect_world(r));
+    };
+    count_rays(state, 1);
+};
+BENCHMARK(BM_WorldIntersect);
+
+// Closest hit through the object list (0), the BVH (1) or the shape arrays (2)
+static void BM_WorldClosestHit(benchmark::State &state) {
+    World w = default_world();
+    if (state.range(0) == 1) {
+        w.build_bvh();
+    } else if (state.range(0) == 2) {
+        w.build_shape_arrays();
+    };
+    Ray r = Ray(point(0, 0, -5), vector(0, 0, 1));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(w.closest_hit(r));
+    };
+    count_rays(state, 1);
+};
+BENCHMARK(BM_WorldClosestHit)->Arg(0)->Arg(1)->Arg(2);
+
+// Chapter 6: Light and Shading
+static void BM_MaterialLighting(benchmark::State &state) {
+    Material m = Material();
+    Sphere s = Sphere();
+    PointLight light = PointLight(point(0, 10, -10), Color(1, 1, 1));
+    Tuple position = point(0, 0, 0);
+    Tuple eyev = vector(0, std::sqrt(2) / 2, -std::sqrt(2) / 2);
+    Tuple normalv = vector(0, 0, -1);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(m.lighting(&s, light, position, eyev, normalv, false));
+    };
+};
+BENCHMARK(BM_MaterialLighting);
+
+// Shading one hit in the default world lit by state.range(0) lights, half
+// of them behind the surface
+static void BM_ShadeHitLights(benchmark::State &state) {
+    World w = default_world();
+    w.build_bvh();
+    w.lights.clear();
+    for (int i = 0; i < state.range(0); i++) {
+        float angle = 2 * M_PI * i / state.range(0);
+        w.lights.push_back(PointLight(point(10 * std::cos(angle), 5, 10 * std::sin(angle)), Color(0.1, 0.1, 0.1)));
+    };
+    Ray r = Ray(point(0, 0, -5), vector(0, 0, 1));
+    Computation comp = w.closest_hit(r).prepare_computations(r);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(w.shade_hit(comp));
+    };
+};
+BENCHMARK(BM_ShadeHitLights)->Arg(1)->Arg(8)->Arg(64);
+
+static void BM_CameraRayForPixel(benchmark::State &state) {
+    Camera c = Camera(201, 101, M_PI / 2);
+    c.set_transform(rotation_y_matrix(M_PI / 4) * translation_matrix(0, -2, 5));
+    int x = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(c.ray_for_pixel(x, 50));
+        x = (x + 1) % 201;
+    };
+    count_rays(state, 1);
+};
+BENCHMARK(BM_CameraRayForPixel);
+
+// Full frames; the argument is the number of render threads
+static void BM_RenderDefaultWorld(benchmark::State &state) {
+    World w = default_world();
+    Camera c = Camera(160, 90, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    c.threads = state.range(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(c.render(w));
+    };
+    count_rays(state, c.hsize * c.vsize);
+};
+BENCHMARK(BM_RenderDefaultWorld)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// The scene from challenges/ch10.1.cpp at a reduced resolution
+static void BM_RenderChapter10Scene(benchmark::State &state) {
+    StripePattern black_stripe = StripePattern(Color(1, 1, 1), Color(0.1, 0.1, 0.1));
+    StripePattern maroon = StripePattern(Color(0.9, 0.9, 0.9), Color(0.5, 0, 0), rotation_z_matrix(M_PI / 8) * rotation_y_matrix(-M_PI / 6) * 0.3 * translation_matrix(0.2, 0, 0) * 0.75);
+    StripePattern teal = StripePattern(Color(1, 1, 1), Color(0, 0.5, 0.5), rotation_y_matrix(M_PI / 3) * translation_matrix(0.2, 0, 0));
+    StripePattern orange = StripePattern(Color(1, 1, 1), Color(1, 215.0/255.0, 0), scaling_matrix(0.13, 0.13, 0.13F) * rotation_z_matrix(M_PI / 10) * translation_matrix(0.2, 0, 0));
+
+    Plane floor = Plane(identity_matrix(4), Material(&black_stripe, Color(1, 0.9, 0.9), 0.1, 0.5, 0, 0));
+    Sphere middle = Sphere(translation_matrix(-0.5, 1, 0.5), Material(&maroon, Color(1, 1, 1), 0.1, 0.7, 0.3, 200.0));
+    Sphere right = Sphere(translation_matrix(1.5, 0.5, -0.5) * scaling_matrix(0.5, 0.5, 0.5), Material(&teal, Color(1, 1, 1), 0.1, 0.7, 0.3, 200.0));
+    Sphere left = Sphere(translation_matrix(-1.5, 0.33, -0.75) * scaling_matrix(0.33, 0.33, 0.33), Material(&orange, Color(1, 0.8, 0.1), 0.1, 0.7, 0.3, 200.0));
+    World w(
+        std::vector<Shape *> {&floor, &middle, &left, &right},
+        PointLight(point(-10, 10, -10), Color(1, 1, 1))
+    );
+
+    Camera c = Camera(320, 180, M_PI / 3);
+    c.set_transform(view_transform(point(0, 1.5, -5), point(0, 1, 0), vector(0, 1, 0)));
+    c.threads = state.range(0);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(c.render(w));
+    };
+    count_rays(state, c.hsize * c.vsize);
+};
+BENCHMARK(BM_RenderChapter10Scene)->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <iomanip>
 #include <chrono>
+#include <thread>
 
 #include "ray_tracer.h"
 
@@ -80,11 +81,12 @@ int main() {
     unsigned int x = 1280;
     unsigned int y = 720;
     Camera camera(x, y, M_PI / 3);
-    camera.transform = view_transform(
+    camera.set_transform(view_transform(
         point(0, 1.5, -5),
         point(0, 1, 0),
         vector(0, 1, 0)
-    );
+    ));
+    camera.threads = std::thread::hardware_concurrency();
 
     // Create world
     World w(
@@ -108,8 +110,8 @@ int main() {
 
     auto stop = high_resolution_clock::now();
 
-    std::string filename = "values.ppm";
-    image.write_to_ppm(filename);
+    std::string filename = "values.png";
+    image.write_to_png(filename, camera.threads);
 
     std::cout << "Charted at " << filename << std::endl;
 
@@ -92,11 +92,11 @@ int main() {
     unsigned int x = 720;
     unsigned int y = 1280;
     Camera camera(x, y, M_PI / 2);
-    camera.transform = view_transform(
+    camera.set_transform(view_transform(
         point(0, 1.5, -5),
         point(0, 1, 0),
         vector(0, 1, 0)
-    );
+    ));
 
     // Create world
     World w(std::vector<Sphere> {floor, left_wall, right_wall, middle, left, right}, light);
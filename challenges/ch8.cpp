@@ -149,11 +149,11 @@ int main() {
     unsigned int x = 100;
     unsigned int y = 100;
     Camera camera(x, y, M_PI * 1.4 / 3.0);
-    camera.transform = view_transform(
+    camera.set_transform(view_transform(
         point(2, 2, 8),
         point(-2, 0, 0),
         vector(0, 1, 0)
-    );
+    ));
 
     // Create world
     World w(
@@ -70,11 +70,11 @@ int main() {
     unsigned int x = 128;
     unsigned int y = 72;
     Camera camera(x, y, M_PI / 3);
-    camera.transform = view_transform(
+    camera.set_transform(view_transform(
         point(0, 1.5, -5),
         point(0, 1, 0),
         vector(0, 1, 0)
-    );
+    ));
 
     // Create world
     World w(
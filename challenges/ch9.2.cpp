@@ -113,11 +113,11 @@ int main() {
     unsigned int x = 1200;
     unsigned int y = 840;
     Camera camera(x, y, M_PI / 2);
-    camera.transform = view_transform(
+    camera.set_transform(view_transform(
         point(0, 3, -5),
         point(0, 1.3, 0),
         vector(0, 1, 0)
-    );
+    ));
 
     // Create world
     World w(
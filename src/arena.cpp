@@ -0,0 +1,69 @@
+#include "arena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+
+static thread_local Arena * current_arena = NULL;
+
+Arena::Arena() {
+    this->block = 0;
+    this->offset = 0;
+    this->bytes_allocated = 0;
+    this->blocks_allocated = 0;
+};
+
+void * Arena::allocate(std::size_t bytes, std::size_t alignment) {
+    while (true) {
+        if (block < blocks.size()) {
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(blocks[block].get());
+            std::size_t start = ((base + offset + alignment - 1) & ~(std::uintptr_t) (alignment - 1)) - base;
+            if (start + bytes <= block_sizes[block]) {
+                offset = start + bytes;
+                bytes_allocated += bytes;
+                return blocks[block].get() + start;
+            };
+            // Doesn't fit: move on to the next block, reusing it if it exists
+            if (block + 1 < blocks.size() || offset > 0) {
+                block++;
+                offset = 0;
+                continue;
+            };
+        };
+        std::size_t size = std::max(block_size, bytes + alignment);
+        blocks.emplace_back(new unsigned char[size]);
+        block_sizes.push_back(size);
+        blocks_allocated++;
+        block = blocks.size() - 1;
+        offset = 0;
+    };
+};
+
+void Arena::reset() {
+    block = 0;
+    offset = 0;
+};
+
+std::size_t Arena::get_bytes_allocated() const {
+    return bytes_allocated;
+};
+
+std::size_t Arena::get_blocks_allocated() const {
+    return blocks_allocated;
+};
+
+Arena * Arena::current() {
+    return current_arena;
+};
+
+Arena::Scope::Scope(Arena &arena) {
+    this->previous = current_arena;
+    current_arena = &arena;
+};
+
+Arena::Scope::~Scope() {
+    current_arena = previous;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+
+// Bump allocator for short-lived per-ray data. Allocations are carved out
+// of large blocks and are all released together by reset(); the blocks
+// are kept for reuse, so once an arena has warmed up it makes no further
+// calls to the global heap. Nothing is destructed: only use it for
+// trivially destructible data that doesn't outlive the next reset().
+//
+// Each render thread installs its own arena with Arena::Scope, and code
+// on the render path picks it up through Arena::current().
+class Arena {
+    private:
+        std::vector<std::unique_ptr<unsigned char[]>> blocks;
+        std::vector<std::size_t> block_sizes;
+        // Block currently being carved, and the next free byte in it
+        std::size_t block;
+        std::size_t offset;
+        std::size_t bytes_allocated;
+        std::size_t blocks_allocated;
+    public:
+        static constexpr std::size_t block_size = 64 * 1024;
+        Arena();
+        Arena(const Arena &) = delete;
+        Arena &operator=(const Arena &) = delete;
+        void * allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+        template <typename T>
+        T * allocate_array(std::size_t count) {
+            return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+        };
+        // Releases every allocation at once, keeping the blocks
+        void reset();
+        // Totals since construction: bytes handed out, and blocks taken
+        // from the global heap
+        std::size_t get_bytes_allocated() const;
+        std::size_t get_blocks_allocated() const;
+
+        // The calling thread's arena, or NULL outside of a Scope
+        static Arena * current();
+        // Makes an arena the calling thread's current one while in scope
+        class Scope {
+            private:
+                Arena * previous;
+            public:
+                Scope(Arena &arena);
+                ~Scope();
+                Scope(const Scope &) = delete;
+                Scope &operator=(const Scope &) = delete;
+        };
+};
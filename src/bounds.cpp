@@ -0,0 +1,111 @@
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "bounds.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+
+static const float INF = std::numeric_limits<float>::infinity();
+
+BoundingBox::BoundingBox() {
+    this->min = point(INF, INF, INF);
+    this->max = point(-INF, -INF, -INF);
+};
+
+BoundingBox::BoundingBox(const Tuple &min, const Tuple &max) {
+    this->min = min;
+    this->max = max;
+};
+
+BoundingBox BoundingBox::infinite() {
+    return BoundingBox(point(-INF, -INF, -INF), point(INF, INF, INF));
+};
+
+bool BoundingBox::is_empty() const {
+    return min.x > max.x || min.y > max.y || min.z > max.z;
+};
+
+bool BoundingBox::is_infinite() const {
+    return !is_empty() && (std::isinf(min.x) || std::isinf(min.y) || std::isinf(min.z)
+        || std::isinf(max.x) || std::isinf(max.y) || std::isinf(max.z));
+};
+
+void BoundingBox::add_point(const Tuple &p) {
+    min = point(std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z));
+    max = point(std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z));
+};
+
+void BoundingBox::merge(const BoundingBox &b) {
+    if (b.is_empty()) {
+        return;
+    };
+    add_point(b.min);
+    add_point(b.max);
+};
+
+Tuple BoundingBox::centroid() const {
+    return point(
+        (min.x + max.x) * 0.5f,
+        (min.y + max.y) * 0.5f,
+        (min.z + max.z) * 0.5f
+    );
+};
+
+float BoundingBox::surface_area() const {
+    if (is_empty()) {
+        return 0;
+    };
+    Tuple d = max - min;
+    return 2 * (d.x * d.y + d.y * d.z + d.z * d.x);
+};
+
+int BoundingBox::longest_axis() const {
+    Tuple d = max - min;
+    if (d.x >= d.y && d.x >= d.z) {
+        return 0;
+    };
+    return (d.y >= d.z) ? 1 : 2;
+};
+
+// Bounds of the transformed box: the box around its eight transformed corners
+BoundingBox BoundingBox::transform(const Matrix4 &m) const {
+    if (is_empty()) {
+        return BoundingBox();
+    };
+    if (is_infinite()) {
+        return BoundingBox::infinite();
+    };
+    BoundingBox result;
+    for (int i = 0; i < 8; i++) {
+        Tuple corner = point(
+            (i & 1) ? max.x : min.x,
+            (i & 2) ? max.y : min.y,
+            (i & 4) ? max.z : min.z
+        );
+        result.add_point(m * corner);
+    };
+    return result;
+};
+
+bool BoundingBox::intersects(const Tuple &origin, const Tuple &inv_direction, float t_min, float t_max) const {
+    float o[3] = {origin.x, origin.y, origin.z};
+    float inv[3] = {inv_direction.x, inv_direction.y, inv_direction.z};
+    float lo[3] = {min.x, min.y, min.z};
+    float hi[3] = {max.x, max.y, max.z};
+    for (int axis = 0; axis < 3; axis++) {
+        float t0 = (lo[axis] - o[axis]) * inv[axis];
+        float t1 = (hi[axis] - o[axis]) * inv[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        };
+        // Written so a NaN from 0 * inf (ray in the slab plane) is ignored
+        t_min = (t0 > t_min) ? t0 : t_min;
+        t_max = (t1 < t_max) ? t1 : t_max;
+        if (t_min > t_max) {
+            return false;
+        };
+    };
+    return true;
+};
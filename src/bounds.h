@@ -0,0 +1,30 @@
+#pragma once
+
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "ray.h"
+
+
+// Axis-aligned bounding box, used to cull shapes before intersecting them.
+// A default constructed box is empty; infinite() covers all of space.
+class BoundingBox {
+    public:
+        // Attributes
+        Tuple min;
+        Tuple max;
+        // Methods
+        BoundingBox();
+        BoundingBox(const Tuple &min, const Tuple &max);
+        static BoundingBox infinite();
+        bool is_empty() const;
+        bool is_infinite() const;
+        void add_point(const Tuple &p);
+        void merge(const BoundingBox &b);
+        Tuple centroid() const;
+        float surface_area() const;
+        int longest_axis() const;
+        BoundingBox transform(const Matrix4 &m) const;
+        // Slab test against the ray, limited to t in [t_min, t_max].
+        // inv_direction holds 1 / direction per component.
+        bool intersects(const Tuple &origin, const Tuple &inv_direction, float t_min, float t_max) const;
+};
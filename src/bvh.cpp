@@ -0,0 +1,416 @@
+#include "tuple.h"
+#include "ray.h"
+#include "bounds.h"
+#include "shape.h"
+#include "intersection.h"
+#include "intersections.h"
+#include "bvh.h"
+#include "ray_packet.h"
+
+#include <vector>
+#include <stdexcept>
+#include <limits>
+#include <algorithm>
+
+
+BVH::BVH() {
+    this->shape_count = 0;
+};
+
+bool BVH::is_built() const {
+    return shape_count > 0;
+};
+
+unsigned int BVH::get_shape_count() const {
+    return shape_count;
+};
+
+unsigned int BVH::get_node_count() const {
+    return nodes.size();
+};
+
+const std::vector<BVHNode> &BVH::get_nodes() const {
+    return nodes;
+};
+
+const std::vector<Shape *> &BVH::get_shapes() const {
+    return shapes;
+};
+
+const std::vector<Shape *> &BVH::get_unbounded() const {
+    return unbounded;
+};
+
+void BVH::restore(const std::vector<BVHNode> &nodes, const std::vector<Shape *> &shapes, const std::vector<Shape *> &unbounded) {
+    // Interior nodes keep their first child right after them and the
+    // second at offset. Requiring children to come later and every node
+    // but the root to have exactly one parent rules out cycles and shared
+    // subtrees, and the traversal stack relies on the depth limit. Each
+    // shape must sit in exactly one leaf.
+    if (nodes.empty() && !shapes.empty()) {
+        throw std::invalid_argument("A BVH with shapes needs nodes.");
+    };
+    std::vector<unsigned int> depth(nodes.size(), 0);
+    std::vector<bool> has_parent(nodes.size(), false);
+    std::vector<bool> in_leaf(shapes.size(), false);
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        const BVHNode &node = nodes[i];
+        if (i > 0 && !has_parent[i]) {
+            throw std::invalid_argument("BVH nodes must form a single tree.");
+        };
+        if (node.count > 0) {
+            if (node.offset > shapes.size() || node.count > shapes.size() - node.offset) {
+                throw std::invalid_argument("BVH leaf refers to shapes outside the list.");
+            };
+            for (unsigned int j = node.offset; j < node.offset + node.count; j++) {
+                if (in_leaf[j]) {
+                    throw std::invalid_argument("BVH leaves overlap.");
+                };
+                in_leaf[j] = true;
+            };
+            continue;
+        };
+        if (node.axis > 2 || node.offset <= i + 1 || node.offset >= nodes.size()) {
+            throw std::invalid_argument("BVH interior node has invalid children.");
+        };
+        if (depth[i] + 1 > max_depth) {
+            throw std::invalid_argument("BVH is deeper than the traversal supports.");
+        };
+        for (unsigned int child : {i + 1, node.offset}) {
+            if (has_parent[child]) {
+                throw std::invalid_argument("BVH nodes must form a single tree.");
+            };
+            has_parent[child] = true;
+            depth[child] = depth[i] + 1;
+        };
+    };
+    if (std::find(in_leaf.begin(), in_leaf.end(), false) != in_leaf.end()) {
+        throw std::invalid_argument("BVH leaves miss some shapes.");
+    };
+    this->nodes = nodes;
+    this->shapes = shapes;
+    this->unbounded = unbounded;
+    this->shape_count = shapes.size() + unbounded.size();
+};
+
+void BVH::build(const std::vector<Shape *> &objects) {
+    nodes.clear();
+    shapes.clear();
+    unbounded.clear();
+    shape_count = objects.size();
+
+    std::vector<BuildEntry> entries;
+    for (Shape * s : objects) {
+        BoundingBox box = (*s).bounds();
+        if (box.is_infinite()) {
+            unbounded.push_back(s);
+        } else {
+            entries.push_back(BuildEntry{box, box.centroid(), s});
+        };
+    };
+    if (entries.empty()) {
+        return;
+    };
+    nodes.reserve(2 * entries.size());
+    build_recursive(entries, 0, entries.size(), 0);
+    for (BuildEntry &e : entries) {
+        shapes.push_back(e.shape);
+    };
+};
+
+// Splits entries[start, end) with binned SAH and returns the node's index
+unsigned int BVH::build_recursive(std::vector<BuildEntry> &entries, unsigned int start, unsigned int end, unsigned int depth) {
+    const int bucket_count = 12;
+    const unsigned int max_leaf_size = 4;
+
+    unsigned int index = nodes.size();
+    nodes.push_back(BVHNode());
+
+    BoundingBox box, centroid_box;
+    for (unsigned int i = start; i < end; i++) {
+        box.merge(entries[i].box);
+        centroid_box.add_point(entries[i].centroid);
+    };
+    nodes[index].box = box;
+
+    unsigned int count = end - start;
+    int axis = centroid_box.longest_axis();
+    float axis_min = (axis == 0) ? centroid_box.min.x : (axis == 1) ? centroid_box.min.y : centroid_box.min.z;
+    float axis_max = (axis == 0) ? centroid_box.max.x : (axis == 1) ? centroid_box.max.y : centroid_box.max.z;
+    auto coordinate = [axis](const Tuple &p) {
+        return (axis == 0) ? p.x : (axis == 1) ? p.y : p.z;
+    };
+
+    if (count == 1 || axis_max == axis_min || depth >= max_depth) {
+        nodes[index].offset = start;
+        nodes[index].count = count;
+        return index;
+    };
+
+    // Bin the centroids and evaluate the SAH cost of splitting after each bucket
+    BoundingBox bucket_boxes[bucket_count];
+    unsigned int bucket_counts[bucket_count] = {};
+    auto bucket_of = [&](const Tuple &c) {
+        int b = bucket_count * (coordinate(c) - axis_min) / (axis_max - axis_min);
+        return std::min(b, bucket_count - 1);
+    };
+    for (unsigned int i = start; i < end; i++) {
+        int b = bucket_of(entries[i].centroid);
+        bucket_counts[b]++;
+        bucket_boxes[b].merge(entries[i].box);
+    };
+
+    float best_cost = -1;
+    int best_split = 0;
+    for (int split = 0; split < bucket_count - 1; split++) {
+        BoundingBox left, right;
+        unsigned int left_count = 0, right_count = 0;
+        for (int b = 0; b <= split; b++) {
+            left.merge(bucket_boxes[b]);
+            left_count += bucket_counts[b];
+        };
+        for (int b = split + 1; b < bucket_count; b++) {
+            right.merge(bucket_boxes[b]);
+            right_count += bucket_counts[b];
+        };
+        float cost = 0.125f + (left_count * left.surface_area() + right_count * right.surface_area()) / box.surface_area();
+        if (best_cost < 0 || cost < best_cost) {
+            best_cost = cost;
+            best_split = split;
+        };
+    };
+
+    if (count <= max_leaf_size && best_cost >= count) {
+        nodes[index].offset = start;
+        nodes[index].count = count;
+        return index;
+    };
+
+    auto middle_it = std::partition(
+        entries.begin() + start,
+        entries.begin() + end,
+        [&](BuildEntry &e) { return bucket_of(e.centroid) <= best_split; }
+    );
+    unsigned int middle = middle_it - entries.begin();
+    if (middle == start || middle == end) {
+        middle = (start + end) / 2;
+        std::nth_element(
+            entries.begin() + start,
+            entries.begin() + middle,
+            entries.begin() + end,
+            [&](BuildEntry &a, BuildEntry &b) { return coordinate(a.centroid) < coordinate(b.centroid); }
+        );
+    };
+
+    build_recursive(entries, start, middle, depth + 1);
+    unsigned int second = build_recursive(entries, middle, end, depth + 1);
+    nodes[index].offset = second;
+    nodes[index].count = 0;
+    nodes[index].axis = axis;
+    return index;
+};
+
+void BVH::intersect(const Ray &r, Intersections &hits, float t_min, float t_max) const {
+    for (Shape * s : unbounded) {
+        (*s).intersect_into(r, hits);
+    };
+    if (nodes.empty()) {
+        return;
+    };
+
+    const Tuple &origin = r.get_origin();
+    const Tuple &direction = r.get_direction();
+    Tuple inv_direction = vector(1 / direction.x, 1 / direction.y, 1 / direction.z);
+
+    unsigned int stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const BVHNode &node = nodes[stack[--top]];
+        if (!node.box.intersects(origin, inv_direction, t_min, t_max)) {
+            continue;
+        };
+        if (node.count > 0) {
+            for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+                (*shapes[i]).intersect_into(r, hits);
+            };
+        } else {
+            unsigned int current = &node - nodes.data();
+            stack[top++] = node.offset;
+            stack[top++] = current + 1;
+        };
+    };
+};
+
+bool BVH::occluded(const Ray &r, float t_max) const {
+    for (Shape * s : unbounded) {
+        if ((*s).occludes(r, t_max)) {
+            return true;
+        };
+    };
+    if (nodes.empty()) {
+        return false;
+    };
+
+    const Tuple &origin = r.get_origin();
+    const Tuple &direction = r.get_direction();
+    Tuple inv_direction = vector(1 / direction.x, 1 / direction.y, 1 / direction.z);
+
+    unsigned int stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const BVHNode &node = nodes[stack[--top]];
+        if (!node.box.intersects(origin, inv_direction, 0, t_max)) {
+            continue;
+        };
+        if (node.count > 0) {
+            for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+                if ((*shapes[i]).occludes(r, t_max)) {
+                    return true;
+                };
+            };
+        } else {
+            unsigned int current = &node - nodes.data();
+            stack[top++] = node.offset;
+            stack[top++] = current + 1;
+        };
+    };
+    return false;
+};
+
+Intersection BVH::closest_hit(const Ray &r) const {
+    float t_max = std::numeric_limits<float>::infinity();
+    Shape * closest = NULL;
+    float t;
+    for (Shape * s : unbounded) {
+        if ((*s).nearest_hit(r, t_max, t)) {
+            t_max = t;
+            closest = s;
+        };
+    };
+
+    if (!nodes.empty()) {
+        const Tuple &origin = r.get_origin();
+        const Tuple &direction = r.get_direction();
+        Tuple inv_direction = vector(1 / direction.x, 1 / direction.y, 1 / direction.z);
+        bool negative[3] = {direction.x < 0, direction.y < 0, direction.z < 0};
+
+        unsigned int stack[max_depth + 2];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const BVHNode &node = nodes[stack[--top]];
+            // Inclusive of t_max so a tie with the current closest is still checked
+            if (!node.box.intersects(origin, inv_direction, 0, t_max)) {
+                continue;
+            };
+            if (node.count > 0) {
+                for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+                    if ((*shapes[i]).nearest_hit(r, t_max, t)) {
+                        t_max = t;
+                        closest = shapes[i];
+                    };
+                };
+            } else {
+                unsigned int current = &node - nodes.data();
+                if (negative[node.axis]) {
+                    stack[top++] = current + 1;
+                    stack[top++] = node.offset;
+                } else {
+                    stack[top++] = node.offset;
+                    stack[top++] = current + 1;
+                };
+            };
+        };
+    };
+
+    return (closest == NULL) ? Intersection() : Intersection(t_max, closest);
+};
+
+// Slab test of every lane against one box, as BoundingBox::intersects.
+// Returns the mask of active lanes that cross it with 0 <= t <= hits.t.
+static unsigned int packet_intersects(
+    const BoundingBox &box,
+    const RayPacket &r,
+    const float inv[3][RayPacket::size],
+    const PacketHits &hits
+) {
+    const unsigned int n = RayPacket::size;
+    const float *o[3] = {r.ox, r.oy, r.oz};
+    float lo[3] = {box.min.x, box.min.y, box.min.z};
+    float hi[3] = {box.max.x, box.max.y, box.max.z};
+    float t_min[n];
+    float t_max[n];
+    for (unsigned int i = 0; i < n; i++) {
+        t_min[i] = 0;
+        t_max[i] = hits.t[i];
+    };
+    for (int axis = 0; axis < 3; axis++) {
+        for (unsigned int i = 0; i < n; i++) {
+            float t0 = (lo[axis] - o[axis][i]) * inv[axis][i];
+            float t1 = (hi[axis] - o[axis][i]) * inv[axis][i];
+            bool swap = t0 > t1;
+            float near = swap ? t1 : t0;
+            float far = swap ? t0 : t1;
+            // NaN from 0 * inf (ray in the slab plane) leaves the range alone
+            t_min[i] = (near > t_min[i]) ? near : t_min[i];
+            t_max[i] = (far < t_max[i]) ? far : t_max[i];
+        };
+    };
+    unsigned int mask = 0;
+    for (unsigned int i = 0; i < n; i++) {
+        mask |= (unsigned int) (t_min[i] <= t_max[i]) << i;
+    };
+    return mask & r.active;
+};
+
+void BVH::closest_hits(const RayPacket &r, PacketHits &hits) const {
+    for (Shape * s : unbounded) {
+        (*s).nearest_hits(r, hits);
+    };
+    if (nodes.empty() || r.active == 0) {
+        return;
+    };
+
+    const unsigned int n = RayPacket::size;
+    float inv[3][n];
+    for (unsigned int i = 0; i < n; i++) {
+        inv[0][i] = 1 / r.dx[i];
+        inv[1][i] = 1 / r.dy[i];
+        inv[2][i] = 1 / r.dz[i];
+    };
+    // Packets are coherent, so one active lane decides the visiting order
+    unsigned int lead = 0;
+    while (!r.is_active(lead)) {
+        lead++;
+    };
+    bool negative[3] = {r.dx[lead] < 0, r.dy[lead] < 0, r.dz[lead] < 0};
+
+    RayPacket lanes = r;
+    unsigned int stack[max_depth + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const BVHNode &node = nodes[stack[--top]];
+        unsigned int mask = packet_intersects(node.box, r, inv, hits);
+        if (mask == 0) {
+            continue;
+        };
+        if (node.count > 0) {
+            lanes.active = mask;
+            for (unsigned int i = node.offset; i < node.offset + node.count; i++) {
+                (*shapes[i]).nearest_hits(lanes, hits);
+            };
+        } else {
+            unsigned int current = &node - nodes.data();
+            if (negative[node.axis]) {
+                stack[top++] = current + 1;
+                stack[top++] = node.offset;
+            } else {
+                stack[top++] = node.offset;
+                stack[top++] = current + 1;
+            };
+        };
+    };
+};
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "tuple.h"
+#include "ray.h"
+#include "bounds.h"
+#include "intersection.h"
+#include "intersections.h"
+#include "ray_packet.h"
+
+#include <vector>
+
+class Shape;
+
+// Node of the flattened hierarchy. Nodes are stored depth first, so an
+// interior node's first child is the next node in the array and offset
+// points at its second child. For leaves, offset is the first entry in the
+// BVH's shape list and count how many shapes follow.
+struct BVHNode {
+    BoundingBox box;
+    unsigned int offset;
+    unsigned int count;
+    // Split axis of interior nodes, used to visit the nearer child first
+    unsigned int axis;
+};
+
+// Bounding volume hierarchy over the shapes of a World, built with the
+// surface area heuristic. Shapes with infinite bounds (planes) can't be
+// placed in the tree and are kept in a separate list that every query
+// tests directly.
+class BVH {
+    private:
+        // Bounds the traversal stack; deeper subtrees become leaves
+        static const unsigned int max_depth = 48;
+        std::vector<BVHNode> nodes;
+        std::vector<Shape *> shapes;
+        std::vector<Shape *> unbounded;
+        unsigned int shape_count;
+        struct BuildEntry {
+            BoundingBox box;
+            Tuple centroid;
+            Shape * shape;
+        };
+        unsigned int build_recursive(std::vector<BuildEntry> &entries, unsigned int start, unsigned int end, unsigned int depth);
+    public:
+        BVH();
+        void build(const std::vector<Shape *> &objects);
+        bool is_built() const;
+        unsigned int get_shape_count() const;
+        unsigned int get_node_count() const;
+        // The flattened tree, with shapes in leaf order, so it can be saved
+        // and later restored for the same shapes without rebuilding
+        const std::vector<BVHNode> &get_nodes() const;
+        const std::vector<Shape *> &get_shapes() const;
+        const std::vector<Shape *> &get_unbounded() const;
+        // Throws std::invalid_argument unless the nodes form a tree no
+        // deeper than max_depth whose leaves hold each of shapes once
+        void restore(const std::vector<BVHNode> &nodes, const std::vector<Shape *> &shapes, const std::vector<Shape *> &unbounded);
+        // Appends the intersections of every shape whose bounds the ray
+        // crosses for some t in [t_min, t_max]
+        void intersect(const Ray &r, Intersections &hits, float t_min, float t_max) const;
+        // True as soon as any shape is hit with 0 <= t < t_max
+        bool occluded(const Ray &r, float t_max) const;
+        // Nearest hit with 0 <= t, or an empty Intersection
+        Intersection closest_hit(const Ray &r) const;
+        // closest_hit for every active lane of a packet. A node is visited
+        // when any lane crosses its box, and only those lanes test its shapes.
+        void closest_hits(const RayPacket &r, PacketHits &hits) const;
+};
@@ -1,11 +1,22 @@
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "canvas.h"
 #include "world.h"
+#include "arena.h"
 #include <vector>
 #include <string>
 #include <math.h>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <new>
+#include <type_traits>
 
 #include <iostream>
 
@@ -31,37 +42,458 @@ Camera::Camera(unsigned int hsize, unsigned int vsize, float field_of_view) {
     this->hsize = hsize;
     this->vsize = vsize;
     this->field_of_view = field_of_view;
+
+    this->threads = 1;
+    this->tile_size = 16;
+    this->supersampling = 1;
+    this->aa_threshold = 0.001;
+    set_transform(Matrix4());
+};
+
+// The canvas sits at z = -1 in camera space, and the point for pixel
+// (px, py) is linear in px and py. Transformed to world space, the ray
+// direction is then corner_direction + px * pixel_dx + py * pixel_dy, so
+// nothing needs inverting or transforming per pixel.
+void Camera::set_transform(const Matrix4 &transform) {
+    this->transform = transform;
+    this->inverse = transform.inverse();
+    this->origin = inverse * point(0, 0, 0);
+
+    // The untransformed coordinates of the centre of pixel (0, 0)
+    float world_x = half_width - 0.5f * pixel_size;
+    float world_y = half_height - 0.5f * pixel_size;
+    this->corner_direction = inverse * point(world_x, world_y, -1) - origin;
+    this->pixel_dx = inverse * vector(-pixel_size, 0, 0);
+    this->pixel_dy = inverse * vector(0, -pixel_size, 0);
+};
+
+const Matrix4 &Camera::get_transform() const {
+    return transform;
 };
 
-Ray Camera::ray_for_pixel(int px, int py) {
+const Matrix4 &Camera::get_inverse() const {
+    return inverse;
+};
 
-    // The offset from the edge of the canvas to the pixel's center
-    float xoffset = (float)((float)px + (float)0.5) * (float)pixel_size;
-    float yoffset = (float)((float)py + (float)0.5) * (float)pixel_size;
+// Directions are stepped along each run of RayPacket::size pixels that
+// starts on a multiple of RayPacket::size. Every way of generating a
+// pixel's ray then does the same float operations, so a pixel renders
+// bit-identically whichever pass, tile or region traces it.
+Tuple Camera::pixel_direction(unsigned int px, unsigned int py) const {
+    unsigned int start = px - px % RayPacket::size;
+    Tuple direction = corner_direction + pixel_dx * (float) start + pixel_dy * (float) py;
+    for (unsigned int x=start; x<px; x++) {
+        direction = direction + pixel_dx;
+    };
+    return direction;
+};
 
-    // The untransformed coordinates of the pixel in world space
-    float world_x = half_width - xoffset;
-    float world_y = half_height - yoffset;
+Ray Camera::ray_for_pixel(int px, int py) const {
+    return Ray(origin, pixel_direction(px, py).normalize());
+};
 
-    // using the camera matrix, transform the canvas point and the origin,
-    // and then compute the the ray's direction vector
-    Tuple pixel = transform.inverse() * point(world_x, world_y, -1);
-    Tuple origin = transform.inverse() * point(0, 0, 0);
-    Tuple direction = (pixel - origin).normalize();
-    
-    return Ray(origin, direction);
+Ray Camera::ray_for_sample(float x, float y) const {
+    Tuple direction = corner_direction + pixel_dx * (x - 0.5f) + pixel_dy * (y - 0.5f);
+    return Ray(origin, direction.normalize());
 };
 
-Canvas Camera::render(World w) {
+RayPacket Camera::packet_for_pixels(unsigned int px, unsigned int py, unsigned int count) const {
+    Tuple direction = pixel_direction(px, py);
+    RayPacket packet;
+    for (unsigned int i=0; i<count && i<RayPacket::size; i++) {
+        if (i > 0) {
+            unsigned int x = px + i;
+            direction = (x % RayPacket::size == 0) ? pixel_direction(x, py) : direction + pixel_dx;
+        };
+        packet.set_ray(i, Ray(origin, direction.normalize()));
+    };
+    return packet;
+};
+
+// Arena storage is never destructed
+static_assert(std::is_trivially_destructible<RayPacket>::value && std::is_trivially_destructible<PacketHits>::value,
+    "RayPacket and PacketHits must be trivially destructible to live in an Arena.");
+
+// Splits area into size x size tiles, clipped to the area
+static std::vector<Tile> split_tiles(const Tile &area, unsigned int size) {
+    std::vector<Tile> tile_list;
+    size = std::max(size, 1u);
+    for (unsigned int y=area.y0; y<area.y1; y+=size) {
+        for (unsigned int x=area.x0; x<area.x1; x+=size) {
+            tile_list.push_back(Tile{
+                x, y, std::min(x + size, area.x1), std::min(y + size, area.y1)
+            });
+        };
+    };
+    return tile_list;
+};
+
+std::vector<Tile> Camera::tiles() const {
+    return split_tiles(Tile{0, 0, hsize, vsize}, tile_size);
+};
+
+void Camera::render_tile(const World &w, Canvas &image, const Tile &tile, unsigned int x0, unsigned int y0) const {
+    // Each row of the tile is traced as packets of neighbouring pixels. All
+    // of the tile's packets are intersected before any is shaded, so the
+    // acceleration structure and then the materials and lights stay hot in
+    // cache. The packets and their hits are scratch in the thread's arena,
+    // or a local one when called outside a render.
+    Arena local;
+    Arena *arena = Arena::current() != NULL ? Arena::current() : &local;
+    unsigned int per_row = (tile.x1 - tile.x0 + RayPacket::size - 1) / RayPacket::size;
+    std::size_t count = (std::size_t) per_row * (tile.y1 - tile.y0);
+    RayPacket *packets = (*arena).allocate_array<RayPacket>(count);
+    PacketHits *hits = (*arena).allocate_array<PacketHits>(count);
+
+    std::size_t k = 0;
+    for (unsigned int y=tile.y0; y<tile.y1; y++) {
+        for (unsigned int x=tile.x0; x<tile.x1; x+=RayPacket::size, k++) {
+            new (&packets[k]) RayPacket(packet_for_pixels(x, y, tile.x1 - x));
+            new (&hits[k]) PacketHits();
+            w.closest_hits(packets[k], hits[k]);
+        };
+    };
+    k = 0;
+    for (unsigned int y=tile.y0; y<tile.y1; y++) {
+        Color * pixels = image.row(y - y0);
+        for (unsigned int x=tile.x0; x<tile.x1; x+=RayPacket::size, k++) {
+            w.shade_hits(packets[k], hits[k], pixels + (x - x0));
+        };
+    };
+};
+
+// Relative luminance of a colour as it will be written out, i.e. clamped
+static float luminance(const Color &c) {
+    return 0.2126f * std::clamp(c.red, 0.0f, 1.0f)
+        + 0.7152f * std::clamp(c.green, 0.0f, 1.0f)
+        + 0.0722f * std::clamp(c.blue, 0.0f, 1.0f);
+};
+
+// Variance of the luminance over the 3x3 pixels around (x, y), clipped to
+// the pixels of the frame that image holds, starting from (x0, y0)
+static float luminance_variance(const Canvas &image, unsigned int x0, unsigned int y0, unsigned int x, unsigned int y) {
+    float sum = 0, sum_squares = 0;
+    unsigned int count = 0;
+    unsigned int x1 = std::min(x + 2, x0 + image.get_width());
+    unsigned int y1 = std::min(y + 2, y0 + image.get_height());
+    for (unsigned int j=std::max(y, y0 + 1) - 1; j<y1; j++) {
+        const Color * pixels = image.row(j - y0);
+        for (unsigned int i=std::max(x, x0 + 1) - 1; i<x1; i++) {
+            float l = luminance(pixels[i - x0]);
+            sum += l;
+            sum_squares += l * l;
+            count++;
+        };
+    };
+    float mean = sum / count;
+    return sum_squares / count - mean * mean;
+};
+
+// Offset in [0, 1) of sample s within its stratum of pixel (x, y). A hash
+// rather than a random generator, so renders are repeatable and don't
+// depend on which thread rendered a tile.
+static float jitter(unsigned int x, unsigned int y, unsigned int s) {
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u ^ s * 0xcb1ab31fu;
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return (h >> 8) * (1.0f / (1u << 24));
+};
+
+void Camera::supersample_tile(
+    const World &w,
+    const Canvas &centres, unsigned int cx0, unsigned int cy0,
+    Canvas &image, unsigned int x0, unsigned int y0,
+    const Tile &tile, std::size_t &samples, std::size_t &pixels
+) const {
+    unsigned int n = supersampling;
+    unsigned int count = n * n;
+    Color colors[RayPacket::size];
+    for (unsigned int y=tile.y0; y<tile.y1; y++) {
+        for (unsigned int x=tile.x0; x<tile.x1; x++) {
+            if (luminance_variance(centres, cx0, cy0, x, y) <= aa_threshold) {
+                continue;
+            };
+            // One sample in each cell of an n x n grid over the pixel,
+            // traced a packet at a time
+            Color sum;
+            RayPacket packet;
+            unsigned int lane = 0;
+            for (unsigned int s=0; s<count; s++) {
+                float sx = x + ((s % n) + jitter(x, y, 2 * s)) / n;
+                float sy = y + ((s / n) + jitter(x, y, 2 * s + 1)) / n;
+                packet.set_ray(lane++, ray_for_sample(sx, sy));
+                if (lane == RayPacket::size || s == count - 1) {
+                    w.colors_at(packet, colors);
+                    for (unsigned int i=0; i<lane; i++) {
+                        sum = sum + colors[i];
+                    };
+                    packet = RayPacket();
+                    lane = 0;
+                };
+            };
+            image.write_pixel(sum * (1.0f / count), x - x0, y - y0);
+            samples += count;
+            pixels++;
+        };
+    };
+};
+
+// Runs job for every tile index below count, on up to arenas.size()
+// threads with one arena each. Each worker owns a contiguous run of tiles and claims them through
+// its own atomic cursor. Once its run is exhausted it steals from the other
+// workers' cursors, so uneven tiles don't leave threads idle. Jobs must
+// only write to their own tile.
+static void run_tiles(unsigned int count, std::vector<Arena> &arenas, const std::function<void(unsigned int)> &job) {
+    unsigned int worker_count = std::min<std::size_t>(arenas.size(), count);
+    if (worker_count <= 1) {
+        Arena::Scope scope(arenas[0]);
+        for (unsigned int index=0; index<count; index++) {
+            job(index);
+            arenas[0].reset();
+        };
+        return;
+    };
+
+    std::vector<std::atomic<unsigned int>> next(worker_count);
+    std::vector<unsigned int> end(worker_count);
+    unsigned int per_worker = count / worker_count;
+    unsigned int remainder = count % worker_count;
+    unsigned int start = 0;
+    for (unsigned int i=0; i<worker_count; i++) {
+        next[i] = start;
+        start += per_worker + (i < remainder ? 1 : 0);
+        end[i] = start;
+    };
+
+    auto worker = [&](unsigned int id) {
+        Arena::Scope scope(arenas[id]);
+        for (unsigned int k=0; k<worker_count; k++) {
+            unsigned int victim = (id + k) % worker_count;
+            unsigned int index;
+            while ((index = next[victim].fetch_add(1)) < end[victim]) {
+                job(index);
+                arenas[id].reset();
+            };
+        };
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned int i=1; i<worker_count; i++) {
+        pool.emplace_back(worker, i);
+    };
+    worker(0);
+    for (std::thread &t : pool) {
+        t.join();
+    };
+};
+
+// The world is shared read-only between workers. If it has no current BVH
+// or shape arrays, a copy with a BVH is built into with_bvh for the render.
+static const World &world_to_render(const World &world, World &with_bvh) {
+    if (world.has_bvh() || world.has_shape_arrays()) {
+        return world;
+    };
+    with_bvh = world;
+    with_bvh.build_bvh();
+    return with_bvh;
+};
+
+static void record_stats(RenderStats *stats, const std::vector<Arena> &arenas, std::size_t samples, std::size_t supersampled) {
+    if (stats == NULL) {
+        return;
+    };
+    stats->arena_bytes = 0;
+    stats->arena_blocks = 0;
+    for (const Arena &arena : arenas) {
+        stats->arena_bytes += arena.get_bytes_allocated();
+        stats->arena_blocks += arena.get_blocks_allocated();
+    };
+    stats->samples = samples;
+    stats->supersampled_pixels = supersampled;
+};
+
+Canvas Camera::render(const World &world, RenderStats *stats) const {
+    return render_region(world, Tile{0, 0, hsize, vsize}, stats);
+};
+
+Canvas Camera::render_region(const World &world, const Tile &region, RenderStats *stats) const {
+    return std::move(render_regions(world, std::vector<Tile>{region}, stats)[0]);
+};
+
+std::vector<Canvas> Camera::render_regions(const World &world, const std::vector<Tile> &regions, RenderStats *stats) const {
+    for (const Tile &r : regions) {
+        if (r.x0 >= r.x1 || r.y0 >= r.y1 || r.x1 > hsize || r.y1 > vsize) {
+            throw std::invalid_argument("Regions must be non-empty rectangles within the camera's canvas.");
+        };
+    };
+    World with_bvh;
+    const World &w = world_to_render(world, with_bvh);
+
+    // The variance test for anti-aliasing looks at the centre samples
+    // around each pixel, so those are rendered for a one pixel border
+    // around each region, as far as the frame goes
+    bool antialias = supersampling > 1;
+    std::vector<Tile> areas;
+    std::vector<Canvas> centres;
+    for (const Tile &r : regions) {
+        Tile a = r;
+        if (antialias) {
+            a = Tile{std::max(r.x0, 1u) - 1, std::max(r.y0, 1u) - 1, std::min(r.x1 + 1, hsize), std::min(r.y1 + 1, vsize)};
+        };
+        areas.push_back(a);
+        centres.push_back(Canvas(a.x1 - a.x0, a.y1 - a.y0));
+    };
+
+    // The tiles of all the regions are shared between the workers at once
+    std::vector<Tile> tile_list;
+    std::vector<unsigned int> owner;
+    auto split_all = [&](const std::vector<Tile> &parts) {
+        tile_list.clear();
+        owner.clear();
+        for (unsigned int i=0; i<parts.size(); i++) {
+            for (const Tile &tile : split_tiles(parts[i], tile_size)) {
+                tile_list.push_back(tile);
+                owner.push_back(i);
+            };
+        };
+    };
+
+    // One arena per worker, installed for the worker's thread and reset
+    // after each tile. Each takes a block from the heap on first use and
+    // reuses it for every later tile.
+    std::vector<Arena> arenas(std::max(threads, 1u));
+    std::atomic<std::size_t> samples(0), supersampled(0);
+
+    split_all(areas);
+    run_tiles(tile_list.size(), arenas, [&](unsigned int index) {
+        const Tile &tile = tile_list[index];
+        const Tile &area = areas[owner[index]];
+        render_tile(w, centres[owner[index]], tile, area.x0, area.y0);
+        samples += (tile.x1 - tile.x0) * (tile.y1 - tile.y0);
+    });
+    if (!antialias) {
+        record_stats(stats, arenas, samples, supersampled);
+        return centres;
+    };
+
+    // The variance test needs every centre sample, so it runs as a second
+    // pass that reads the centres and writes the regions' own canvases
+    std::vector<Canvas> images;
+    for (unsigned int i=0; i<regions.size(); i++) {
+        const Tile &r = regions[i];
+        images.push_back(centres[i].crop(r.x0 - areas[i].x0, r.y0 - areas[i].y0, r.x1 - r.x0, r.y1 - r.y0));
+    };
+    split_all(regions);
+    run_tiles(tile_list.size(), arenas, [&](unsigned int index) {
+        unsigned int i = owner[index];
+        std::size_t tile_samples = 0, tile_pixels = 0;
+        supersample_tile(
+            w,
+            centres[i], areas[i].x0, areas[i].y0,
+            images[i], regions[i].x0, regions[i].y0,
+            tile_list[index], tile_samples, tile_pixels
+        );
+        samples += tile_samples;
+        supersampled += tile_pixels;
+    });
+
+    record_stats(stats, arenas, samples, supersampled);
+    return images;
+};
+
+void Camera::refine_tile(const World &w, Canvas &image, const Tile &tile, unsigned int block, std::size_t &samples) const {
+    // Tiles start on multiples of progressive_block, so the pixels traced
+    // by the pass before, with twice the block size, are those on even
+    // multiples of block in both directions
+    bool first = block == progressive_block;
+    Color colors[RayPacket::size];
+    unsigned int anchors[RayPacket::size];
+    for (unsigned int y=tile.y0; y<tile.y1; y+=block) {
+        bool row_traced = !first && (y / block) % 2 == 0;
+        unsigned int y1 = std::min(y + block, tile.y1);
+        RayPacket packet;
+        unsigned int lane = 0;
+        auto flush = [&]() {
+            w.colors_at(packet, colors);
+            for (unsigned int i=0; i<lane; i++) {
+                unsigned int x1 = std::min(anchors[i] + block, tile.x1);
+                for (unsigned int j=y; j<y1; j++) {
+                    std::fill(image.row(j) + anchors[i], image.row(j) + x1, colors[i]);
+                };
+            };
+            samples += lane;
+            packet = RayPacket();
+            lane = 0;
+        };
+        for (unsigned int x=tile.x0; x<tile.x1; x+=block) {
+            if (row_traced && (x / block) % 2 == 0) {
+                continue;
+            };
+            anchors[lane] = x;
+            packet.set_ray(lane++, ray_for_pixel(x, y));
+            if (lane == RayPacket::size) {
+                flush();
+            };
+        };
+        if (lane > 0) {
+            flush();
+        };
+    };
+};
+
+Canvas Camera::render_progressive(
+    const World &world,
+    const ProgressCallback &on_pass,
+    std::chrono::steady_clock::time_point deadline,
+    RenderStats *stats
+) const {
     Canvas image(hsize, vsize);
+    // Blocks must not straddle tiles, so tiles are rounded up to whole blocks
+    unsigned int size = std::max(tile_size, 1u);
+    size = (size + progressive_block - 1) / progressive_block * progressive_block;
+    std::vector<Tile> tile_list = split_tiles(Tile{0, 0, hsize, vsize}, size);
+    World with_bvh;
+    const World &w = world_to_render(world, with_bvh);
 
-    for (int x=0; x<hsize; x++) {
-        for (int y=0; y<vsize; y++) {
-            Ray r = ray_for_pixel(x, y);
-            Color c = w.color_at(r);
-            image.write_pixel(c, x, y);
+    std::vector<Arena> arenas(std::max(threads, 1u));
+    std::atomic<std::size_t> samples(0), supersampled(0);
+    std::atomic<bool> out_of_time(false);
+    auto in_time = [&]() {
+        if (!out_of_time && std::chrono::steady_clock::now() >= deadline) {
+            out_of_time = true;
         };
+        return !out_of_time;
+    };
+
+    unsigned int pass = 0;
+    bool stopped = false;
+    for (unsigned int block=progressive_block; block>=1 && !stopped; block/=2, pass++) {
+        run_tiles(tile_list.size(), arenas, [&](unsigned int index) {
+            if (in_time()) {
+                std::size_t tile_samples = 0;
+                refine_tile(w, image, tile_list[index], block, tile_samples);
+                samples += tile_samples;
+            };
+        });
+        stopped = !on_pass(image, pass) || !in_time();
+    };
+
+    if (!stopped && supersampling > 1) {
+        Canvas centres = image;
+        run_tiles(tile_list.size(), arenas, [&](unsigned int index) {
+            if (in_time()) {
+                std::size_t tile_samples = 0, tile_pixels = 0;
+                supersample_tile(w, centres, 0, 0, image, 0, 0, tile_list[index], tile_samples, tile_pixels);
+                samples += tile_samples;
+                supersampled += tile_pixels;
+            };
+        });
+        on_pass(image, pass);
     };
 
+    record_stats(stats, arenas, samples, supersampled);
     return image;
 };
@@ -2,16 +2,66 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "canvas.h"
 #include "world.h"
+#include "ray_packet.h"
 #include <vector>
 #include <string>
+#include <cstddef>
+#include <chrono>
+#include <functional>
 
 
 
+// A rectangle of pixels, [x0, x1) by [y0, y1), rendered as one unit of work
+struct Tile {
+    unsigned int x0, y0, x1, y1;
+};
+
+// Per-frame counters. Each render thread owns an Arena for the per-tile
+// packets and hits of render_tile and any spilled Intersections, reset
+// after every tile; the arena counts are summed over all of them.
+struct RenderStats {
+    // Bytes handed out by the arenas during the frame
+    std::size_t arena_bytes;
+    // Blocks the arenas had to take from the global heap
+    std::size_t arena_blocks;
+    // Camera rays traced, and the pixels that were supersampled
+    std::size_t samples;
+    std::size_t supersampled_pixels;
+};
+
+// Called by Camera::render_progressive after each pass with the image so
+// far and the pass number. Returning false stops the render there.
+using ProgressCallback = std::function<bool(const Canvas &image, unsigned int pass)>;
+
 // Chapter 7: Making a Scene
 class Camera {
+    private:
+        Matrix4 transform;
+        // Cached by set_transform: the inverse, the eye in world space, the
+        // unnormalized world-space direction through pixel (0, 0), and the
+        // change in that direction per pixel along a row and down a column
+        Matrix4 inverse;
+        Tuple origin;
+        Tuple corner_direction;
+        Tuple pixel_dx;
+        Tuple pixel_dy;
+        // Unnormalized direction through the centre of pixel (px, py)
+        Tuple pixel_direction(unsigned int px, unsigned int py) const;
+        // Anti-aliasing pass over one tile, see supersampling below
+        // centres and image hold the pixels of the frame from (cx0, cy0) and
+        // (x0, y0) on
+        void supersample_tile(
+            const World &w,
+            const Canvas &centres, unsigned int cx0, unsigned int cy0,
+            Canvas &image, unsigned int x0, unsigned int y0,
+            const Tile &tile, std::size_t &samples, std::size_t &pixels
+        ) const;
+        // One progressive pass over a tile, see render_progressive
+        void refine_tile(const World &w, Canvas &image, const Tile &tile, unsigned int block, std::size_t &samples) const;
     public:
         // Attributes
         float half_width;
@@ -19,10 +69,55 @@ class Camera {
         unsigned int hsize;
         unsigned int vsize;
         float field_of_view;
-        Matrix transform;
         float pixel_size;
+        // Rendering is split into tile_size x tile_size tiles shared between
+        // this many worker threads. 1 renders on the calling thread.
+        unsigned int threads;
+        unsigned int tile_size;
+        // Adaptive anti-aliasing. Every pixel first gets one ray through its
+        // centre. With supersampling > 1, pixels whose 3x3 neighbourhood has
+        // a luminance variance above aa_threshold are then re-rendered from
+        // supersampling x supersampling stratified, jittered samples.
+        unsigned int supersampling;
+        float aa_threshold;
         // Methods
         Camera(unsigned int hsize, unsigned int vsize, float field_of_view);
-        Ray ray_for_pixel(int px, int py);
-        Canvas render(World w);
+        void set_transform(const Matrix4 &transform);
+        const Matrix4 &get_transform() const;
+        const Matrix4 &get_inverse() const;
+        Ray ray_for_pixel(int px, int py) const;
+        // Ray through a point of the canvas in pixel units, where pixel
+        // (px, py) covers [px, px + 1) x [py, py + 1)
+        Ray ray_for_sample(float x, float y) const;
+        // Rays for up to RayPacket::size pixels of row py, starting at px.
+        // The origin is shared and each direction is one step from the
+        // last; the lanes hold exactly the rays of ray_for_pixel.
+        RayPacket packet_for_pixels(unsigned int px, unsigned int py, unsigned int count) const;
+        std::vector<Tile> tiles() const;
+        // image holds the pixels of the frame from (x0, y0) on
+        void render_tile(const World &w, Canvas &image, const Tile &tile, unsigned int x0 = 0, unsigned int y0 = 0) const;
+        // Fills in stats, if given, once the frame is done
+        Canvas render(const World &w, RenderStats *stats = NULL) const;
+        // Renders only the given rectangles of the frame, each into a canvas
+        // of its own size. Rays, and so pixels, are exactly those of a full
+        // render; Canvas::paste puts a region back in its place. Throws
+        // std::invalid_argument for empty regions or ones outside the frame.
+        Canvas render_region(const World &w, const Tile &region, RenderStats *stats = NULL) const;
+        std::vector<Canvas> render_regions(const World &w, const std::vector<Tile> &regions, RenderStats *stats = NULL) const;
+        // Renders in passes of increasing detail into the same canvas: one
+        // ray per 8x8 block filling the block, then per 4x4, 2x2 and finally
+        // every pixel, each pass only tracing pixels the earlier ones
+        // didn't. The anti-aliasing pass, if enabled, comes last. on_pass
+        // sees the canvas after each pass. Once the deadline has passed no
+        // further tiles are refined, leaving them at the previous pass.
+        // Without a deadline the final image is bit-identical to render().
+        // The call after the anti-aliasing pass comes when there is nothing
+        // left to do, so its return value is ignored.
+        static const unsigned int progressive_block = 8;
+        Canvas render_progressive(
+            const World &w,
+            const ProgressCallback &on_pass,
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max(),
+            RenderStats *stats = NULL
+        ) const;
 };
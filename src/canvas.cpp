@@ -1,96 +1,115 @@
 #include "tuple.h"
 #include "canvas.h"
+#include "png.h"
 #include <vector>
 #include <cmath>
 #include <iostream>
 #include <string>
 #include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
 
 
 // Chapter 1: Tuples, Vectors and Points
 Canvas::Canvas(unsigned int width, unsigned int height) {
     this -> width = width;
     this -> height = height;
-    this -> _canvas = std::vector<std::vector<Color>> (width);
-    for (int i=0;i<width;i++) {
-        _canvas[i] = std::vector<Color> (height);
-    };
+    this -> _canvas = std::vector<Color> (width * height);
 }
 
-unsigned int Canvas::get_width() {
+unsigned int Canvas::get_width() const {
     return width;
 }
 
-unsigned int Canvas::get_height() {
+unsigned int Canvas::get_height() const {
     return height;
 }
 
-Color Canvas::pixel_at(unsigned int x, unsigned int y) {
-    return _canvas[x][y];
+const Color &Canvas::pixel_at(unsigned int x, unsigned int y) const {
+    return _canvas[y * width + x];
 }
 
-void Canvas::write_pixel(Color color, unsigned int x, unsigned int y) {
-    _canvas[x][y] = color;
+void Canvas::write_pixel(const Color &color, unsigned int x, unsigned int y) {
+    _canvas[y * width + x] = color;
     return;
 }
 
-std::string Canvas::ppm_header() {
-    std::string header = "P3\n";
+Color * Canvas::row(unsigned int y) {
+    return _canvas.data() + y * width;
+}
+
+const Color * Canvas::row(unsigned int y) const {
+    return _canvas.data() + y * width;
+}
+
+Canvas Canvas::crop(unsigned int x, unsigned int y, unsigned int width, unsigned int height) const {
+    if (x + width > this->width || y + height > this->height) {
+        throw std::invalid_argument("The cropped area must lie within the canvas.");
+    };
+    Canvas result(width, height);
+    for (unsigned int j = 0; j < height; j++) {
+        std::copy(row(y + j) + x, row(y + j) + x + width, result.row(j));
+    };
+    return result;
+}
+
+void Canvas::paste(const Canvas &other, unsigned int x, unsigned int y) {
+    if (x + other.width > width || y + other.height > height) {
+        throw std::invalid_argument("The pasted canvas must lie within the canvas.");
+    };
+    for (unsigned int j = 0; j < other.height; j++) {
+        std::copy(other.row(j), other.row(j) + other.width, row(y + j) + x);
+    };
+}
+
+std::string Canvas::ppm_header(PPMFormat format) const {
+    std::string header = (format == PPMFormat::P6) ? "P6\n" : "P3\n";
     header += std::to_string(width) + " " + std::to_string(height) + "\n";
     header += "255\n";
     return header;
 };
 
-std::string Canvas::ppm_content() {
+// One row of P3 pixel data, wrapped so no line exceeds 70 characters
+std::string Canvas::ppm_row(unsigned int y) const {
     std::string content;
     std::string line;
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            Color col = _canvas[i][j];
-            std::string red = std::to_string(scale_color(col.red));
-            std::string green = std::to_string(scale_color(col.green));
-            std::string blue = std::to_string(scale_color(col.blue));
-            if (line.length() + red.length() + 1 > 70) {
-                content += line + "\n";
-                line.clear();
-                line += red;
-            } else if (line.length() == 0) {
-                line += red;
-            } else {
-                line += " " + red;
-            };
-            if (line.length() + green.length() + 1> 70) {
+    const Color * pixels = row(y);
+    for (int i = 0; i < width; i++) {
+        Color col = pixels[i];
+        for (float channel : {col.red, col.green, col.blue}) {
+            std::string value = std::to_string(scale_color(channel));
+            if (line.length() + value.length() + 1 > 70) {
                 content += line + "\n";
                 line.clear();
-                line += green;
+                line += value;
             } else if (line.length() == 0) {
-                line += green;
+                line += value;
             } else {
-                line += " " + green;
-            };
-            if (line.length() + blue.length() + 1> 70) {
-                content += line + "\n";
-                line.clear();
-                line += blue;
-            } else if (line.length() == 0) {
-                line += blue;
-            } else {
-                line += " " + blue;
+                line += " " + value;
             };
         };
-        content += line + "\n";
-        line.clear();
+    };
+    content += line + "\n";
+    return content;
+};
+
+std::string Canvas::ppm_content() const {
+    std::string content;
+    for (int j = 0; j < height; j++) {
+        content += ppm_row(j);
     };
     return content;
 }
 
-std::string Canvas::canvas_to_ppm() {
+std::string Canvas::canvas_to_ppm() const {
     std::string ppm = ppm_header();
     ppm += ppm_content();
     return ppm;
 };
 
-unsigned int Canvas::scale_color(float color_value) {
+unsigned int Canvas::scale_color(float color_value) const {
     if (color_value < 0) {
         return 0;
     };
@@ -101,10 +120,79 @@ unsigned int Canvas::scale_color(float color_value) {
     return scaled_value;
 };
 
-void Canvas::write_to_ppm(std::string filename) {
-    std::string ppm_data = canvas_to_ppm();
-    std::ofstream out(filename);
-    out << ppm_data;
-    out.close();
+// Rows are streamed straight to the file through a fixed-size buffer, so
+// writing never holds more than one buffer's worth of output in memory.
+void Canvas::write_to_ppm(const std::string &filename, PPMFormat format) const {
+    std::FILE * file = std::fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        throw std::runtime_error("Could not open " + filename + " for writing.");
+    };
+    std::setvbuf(file, NULL, _IONBF, 0);
+
+    const std::size_t buffer_size = 1 << 16;
+    std::vector<unsigned char> buffer(buffer_size);
+    std::size_t used = 0;
+    bool written = true;
+    auto emit = [&](const unsigned char * data, std::size_t length) {
+        while (length > 0) {
+            if (used == buffer_size) {
+                written = written && std::fwrite(buffer.data(), 1, used, file) == used;
+                used = 0;
+            };
+            std::size_t chunk = std::min(length, buffer_size - used);
+            std::memcpy(buffer.data() + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            length -= chunk;
+        };
+    };
+
+    std::string header = ppm_header(format);
+    emit((const unsigned char *) header.data(), header.size());
+
+    if (format == PPMFormat::P6) {
+        std::vector<unsigned char> row_bytes(width * 3);
+        for (unsigned int y = 0; y < height; y++) {
+            const Color * pixels = row(y);
+            for (unsigned int x = 0; x < width; x++) {
+                row_bytes[x * 3] = scale_color(pixels[x].red);
+                row_bytes[x * 3 + 1] = scale_color(pixels[x].green);
+                row_bytes[x * 3 + 2] = scale_color(pixels[x].blue);
+            };
+            emit(row_bytes.data(), row_bytes.size());
+        };
+    } else {
+        for (unsigned int y = 0; y < height; y++) {
+            std::string line = ppm_row(y);
+            emit((const unsigned char *) line.data(), line.size());
+        };
+    };
+
+    written = written && std::fwrite(buffer.data(), 1, used, file) == used;
+    written = (std::fclose(file) == 0) && written;
+    if (!written) {
+        throw std::runtime_error("Could not write " + filename + ".");
+    };
+    return;
+};
+
+void Canvas::write_to_png(const std::string &filename, unsigned int threads) const {
+    std::vector<uint8_t> rgb(width * height * 3);
+    for (unsigned int i = 0; i < width * height; i++) {
+        rgb[i * 3] = scale_color(_canvas[i].red);
+        rgb[i * 3 + 1] = scale_color(_canvas[i].green);
+        rgb[i * 3 + 2] = scale_color(_canvas[i].blue);
+    };
+    std::vector<uint8_t> png = encode_png(width, height, rgb, threads);
+
+    std::FILE * file = std::fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        throw std::runtime_error("Could not open " + filename + " for writing.");
+    };
+    bool written = std::fwrite(png.data(), 1, png.size(), file) == png.size();
+    written = (std::fclose(file) == 0) && written;
+    if (!written) {
+        throw std::runtime_error("Could not write " + filename + ".");
+    };
     return;
 };
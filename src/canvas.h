@@ -5,27 +5,42 @@
 #include <string>
 
 
+// P3 is the plain-text format from the book, P6 the binary equivalent
+enum class PPMFormat {
+    P3,
+    P6
+};
+
 // Chapter 2: Colors and Canvas
 class Canvas {
     private:
         // Attributes
         unsigned int width, height;
-        std::vector<std::vector<Color>> _canvas;
+        // Row-major: pixel (x, y) lives at _canvas[y * width + x]
+        std::vector<Color> _canvas;
         // Methods
-        std::string ppm_header();
-        std::string ppm_content();
-        unsigned int scale_color(float color_value);
+        std::string ppm_header(PPMFormat format = PPMFormat::P3) const;
+        std::string ppm_content() const;
+        std::string ppm_row(unsigned int y) const;
+        unsigned int scale_color(float color_value) const;
     public:
         // Methods
         Canvas(unsigned int width, unsigned int height);
-        unsigned int get_width();
-        unsigned int get_height();
-        Color pixel_at(unsigned int x, unsigned int y);
-        void write_pixel(Color color, unsigned int x, unsigned int y);
-        std::string canvas_to_ppm();
-        void write_to_ppm(std::string filename = "canvas.ppm");
-        // TODO: implement the conversion from ppm to png.
-        // maybe using this library?
-        // https://www.codeproject.com/Articles/1300/CxImage#:~:text=...%20Convert%20from%20One%20Format%20to%20Another
-        void write_to_png(std::string filename = "canvas.png");
+        unsigned int get_width() const;
+        unsigned int get_height() const;
+        const Color &pixel_at(unsigned int x, unsigned int y) const;
+        void write_pixel(const Color &color, unsigned int x, unsigned int y);
+        // Direct access to the width pixels of row y, for writers and tile renderers
+        Color * row(unsigned int y);
+        const Color * row(unsigned int y) const;
+        // Copies of, and writes into, the width x height block at (x, y).
+        // Throws std::invalid_argument if it doesn't fit in this canvas.
+        Canvas crop(unsigned int x, unsigned int y, unsigned int width, unsigned int height) const;
+        void paste(const Canvas &other, unsigned int x, unsigned int y);
+        std::string canvas_to_ppm() const;
+        // Plain-text P3 by default, as in the book; binary P6 is smaller and
+        // quicker to write
+        void write_to_ppm(const std::string &filename = "canvas.ppm", PPMFormat format = PPMFormat::P3) const;
+        // Encoded in-process, see png.h. threads > 1 compresses row chunks in parallel.
+        void write_to_png(const std::string &filename = "canvas.png", unsigned int threads = 1) const;
 };
\ No newline at end of file
@@ -9,11 +9,11 @@ class Computation {
     public:
         // Attributes
         float t;
-        Shape * object;
+        const Shape * object;
         Tuple point;
         Tuple over_point;
         Tuple eyev;
         Tuple normalv;
         bool inside;
-        Computation(float t, Shape * object, Tuple point, Tuple eyev, Tuple normalv);
+        Computation(float t, const Shape * object, const Tuple &point, const Tuple &eyev, const Tuple &normalv);
 };
@@ -0,0 +1,252 @@
+#include "distributed_render.h"
+#include "canvas.h"
+#include "world.h"
+#include "camera.h"
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <cstdint>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+
+// A job is a region of the frame; the reply is its pixels, row by row, as
+// red, green and blue floats
+struct JobMessage {
+    uint32_t x0, y0, x1, y1;
+};
+
+struct Worker {
+    pid_t pid;
+    int fd;
+    // Index of the job being rendered, or -1 when idle
+    int job;
+};
+
+// Both return false once the other end is gone
+static bool read_all(int fd, void *buffer, std::size_t size) {
+    char *data = static_cast<char *>(buffer);
+    while (size > 0) {
+        ssize_t n = recv(fd, data, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        };
+        if (n <= 0) {
+            return false;
+        };
+        data += n;
+        size -= n;
+    };
+    return true;
+};
+
+static bool write_all(int fd, const void *buffer, std::size_t size) {
+    const char *data = static_cast<const char *>(buffer);
+    while (size > 0) {
+        // MSG_NOSIGNAL: a dead peer is an error here rather than a SIGPIPE
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        };
+        if (n <= 0) {
+            return false;
+        };
+        data += n;
+        size -= n;
+    };
+    return true;
+};
+
+static std::size_t pixel_bytes(const JobMessage &job) {
+    return (std::size_t) (job.x1 - job.x0) * (job.y1 - job.y0) * 3 * sizeof(float);
+};
+
+static void worker_loop(int fd, const World &world, const Camera &camera) {
+    JobMessage job;
+    std::vector<float> data;
+    while (read_all(fd, &job, sizeof(job))) {
+        Canvas part = camera.render_region(world, Tile{job.x0, job.y0, job.x1, job.y1});
+        data.clear();
+        for (unsigned int y=0; y<part.get_height(); y++) {
+            const Color * pixels = part.row(y);
+            for (unsigned int x=0; x<part.get_width(); x++) {
+                data.push_back(pixels[x].red);
+                data.push_back(pixels[x].green);
+                data.push_back(pixels[x].blue);
+            };
+        };
+        if (!write_all(fd, data.data(), data.size() * sizeof(float))) {
+            return;
+        };
+    };
+};
+
+// Closing the socket tells a live worker to exit; a dead one is reaped
+static void stop_worker(Worker &worker, bool kill_it) {
+    if (worker.fd < 0) {
+        return;
+    };
+    if (kill_it) {
+        kill(worker.pid, SIGKILL);
+    };
+    close(worker.fd);
+    worker.fd = -1;
+    waitpid(worker.pid, NULL, 0);
+};
+
+Canvas render_distributed(
+    const World &world,
+    const Camera &camera,
+    unsigned int processes,
+    unsigned int job_size,
+    DistributedStats *stats
+) {
+    // Workers get the world as it is at the fork, so build its BVH first
+    World with_bvh;
+    bool prepared = world.has_bvh() || world.has_shape_arrays();
+    if (!prepared) {
+        with_bvh = world;
+        with_bvh.build_bvh();
+    };
+    const World &w = prepared ? world : with_bvh;
+
+    Camera job_camera = camera;
+    job_camera.tile_size = std::max(job_size, 1u);
+    std::vector<Tile> jobs = job_camera.tiles();
+    std::deque<int> queue;
+    for (unsigned int i=0; i<jobs.size(); i++) {
+        queue.push_back(i);
+    };
+
+    std::vector<Worker> workers;
+    unsigned int worker_count = std::min<std::size_t>(std::max(processes, 1u), jobs.size());
+    for (unsigned int i=0; i<worker_count; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            break;
+        };
+        pid_t pid = fork();
+        if (pid < 0) {
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        };
+        if (pid == 0) {
+            // Only this worker's socket stays open, so every worker sees the
+            // coordinator hang up
+            close(fds[0]);
+            for (Worker &other : workers) {
+                close(other.fd);
+            };
+            try {
+                worker_loop(fds[1], w, camera);
+            } catch (...) {
+                _exit(1);
+            };
+            _exit(0);
+        };
+        close(fds[1]);
+        workers.push_back(Worker{pid, fds[0], -1});
+    };
+    if (workers.empty() && !jobs.empty()) {
+        throw std::runtime_error(std::string("Could not start render workers: ") + std::strerror(errno));
+    };
+
+    Canvas image(camera.hsize, camera.vsize);
+    unsigned int done = 0, failed = 0, reassigned = 0;
+    auto fail = [&](Worker &worker) {
+        if (worker.job >= 0) {
+            queue.push_front(worker.job);
+            reassigned++;
+        };
+        worker.job = -1;
+        stop_worker(worker, true);
+        failed++;
+    };
+
+    std::vector<float> data;
+    std::vector<pollfd> polled;
+    std::vector<Worker *> polled_workers;
+    while (done < jobs.size()) {
+        for (Worker &worker : workers) {
+            if (worker.fd < 0 || worker.job >= 0 || queue.empty()) {
+                continue;
+            };
+            int job = queue.front();
+            queue.pop_front();
+            const Tile &tile = jobs[job];
+            JobMessage message = {tile.x0, tile.y0, tile.x1, tile.y1};
+            worker.job = job;
+            if (!write_all(worker.fd, &message, sizeof(message))) {
+                fail(worker);
+            };
+        };
+
+        polled.clear();
+        polled_workers.clear();
+        for (Worker &worker : workers) {
+            if (worker.fd >= 0 && worker.job >= 0) {
+                polled.push_back(pollfd{worker.fd, POLLIN, 0});
+                polled_workers.push_back(&worker);
+            };
+        };
+        if (polled.empty()) {
+            if (!queue.empty() && std::none_of(workers.begin(), workers.end(), [](const Worker &k) { return k.fd >= 0; })) {
+                throw std::runtime_error("Every render worker failed before the frame was done.");
+            };
+            continue;
+        };
+        if (poll(polled.data(), polled.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            };
+            for (Worker &worker : workers) {
+                stop_worker(worker, true);
+            };
+            throw std::runtime_error(std::string("Waiting for render workers failed: ") + std::strerror(errno));
+        };
+
+        for (unsigned int i=0; i<polled.size(); i++) {
+            if (polled[i].revents == 0) {
+                continue;
+            };
+            Worker &worker = *polled_workers[i];
+            const Tile &tile = jobs[worker.job];
+            JobMessage message = {tile.x0, tile.y0, tile.x1, tile.y1};
+            data.resize(pixel_bytes(message) / sizeof(float));
+            if (!read_all(worker.fd, data.data(), pixel_bytes(message))) {
+                fail(worker);
+                continue;
+            };
+            const float *p = data.data();
+            for (unsigned int y=tile.y0; y<tile.y1; y++) {
+                Color * pixels = image.row(y);
+                for (unsigned int x=tile.x0; x<tile.x1; x++, p+=3) {
+                    pixels[x] = Color(p[0], p[1], p[2]);
+                };
+            };
+            worker.job = -1;
+            done++;
+        };
+    };
+
+    for (Worker &worker : workers) {
+        stop_worker(worker, false);
+    };
+    if (stats != NULL) {
+        stats->jobs = jobs.size();
+        stats->failed_workers = failed;
+        stats->reassigned_jobs = reassigned;
+    };
+    return image;
+};
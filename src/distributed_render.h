@@ -0,0 +1,33 @@
+#pragma once
+
+#include "canvas.h"
+#include "world.h"
+#include "camera.h"
+
+
+// Rendering a frame across local worker processes
+// The frame is split into job_size x job_size regions. The coordinator
+// forks the workers, which inherit a copy of the world, and hands out one
+// region at a time to each over a Unix socket pair; workers render it with
+// Camera::render_region and send back the pixels. If a worker dies or its
+// connection fails, its region goes back in the queue for the others. The
+// image matches camera.render(world).
+//
+// POSIX only. Call it before starting any threads of your own, since only
+// the calling thread survives the fork in the workers.
+struct DistributedStats {
+    unsigned int jobs;
+    // Workers lost during the frame, and regions that were handed out again
+    unsigned int failed_workers;
+    unsigned int reassigned_jobs;
+};
+
+// Throws std::runtime_error if workers can't be started or all of them fail
+// before the frame is done
+Canvas render_distributed(
+    const World &world,
+    const Camera &camera,
+    unsigned int processes,
+    unsigned int job_size = 64,
+    DistributedStats *stats = NULL
+);
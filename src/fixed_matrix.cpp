@@ -0,0 +1,231 @@
+#include "tuple.h"
+#include "matrix.h"
+#include "fixed_matrix.h"
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+
+// Closed-form 4x4 kernels.
+// The 2x2 sub-determinants of the top two rows (s) and bottom two rows (c)
+// are shared between the determinant and every cofactor, so inversion is
+// straight-line code with no recursion or temporaries.
+static bool is_affine_4x4(const float *m) {
+    return m[12] == 0 && m[13] == 0 && m[14] == 0 && m[15] == 1;
+};
+
+static float determinant_4x4(const float *m) {
+    if (is_affine_4x4(m)) {
+        return m[0] * (m[5] * m[10] - m[6] * m[9])
+             - m[1] * (m[4] * m[10] - m[6] * m[8])
+             + m[2] * (m[4] * m[9] - m[5] * m[8]);
+    };
+    float s0 = m[0] * m[5] - m[1] * m[4];
+    float s1 = m[0] * m[6] - m[2] * m[4];
+    float s2 = m[0] * m[7] - m[3] * m[4];
+    float s3 = m[1] * m[6] - m[2] * m[5];
+    float s4 = m[1] * m[7] - m[3] * m[5];
+    float s5 = m[2] * m[7] - m[3] * m[6];
+
+    float c5 = m[10] * m[15] - m[11] * m[14];
+    float c4 = m[9] * m[15] - m[11] * m[13];
+    float c3 = m[9] * m[14] - m[10] * m[13];
+    float c2 = m[8] * m[15] - m[11] * m[12];
+    float c1 = m[8] * m[14] - m[10] * m[12];
+    float c0 = m[8] * m[13] - m[9] * m[12];
+
+    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+};
+
+// Transforms built from translations, rotations, scales and shears keep a
+// bottom row of (0, 0, 0, 1), so only the upper 3x3 needs inverting and the
+// translation column is mapped back through it.
+static void inverse_affine_4x4(const float *m, float *out) {
+    float c00 = m[5] * m[10] - m[6] * m[9];
+    float c01 = m[6] * m[8] - m[4] * m[10];
+    float c02 = m[4] * m[9] - m[5] * m[8];
+    float inv_det = 1 / (m[0] * c00 + m[1] * c01 + m[2] * c02);
+
+    out[0] = c00 * inv_det;
+    out[1] = (m[2] * m[9] - m[1] * m[10]) * inv_det;
+    out[2] = (m[1] * m[6] - m[2] * m[5]) * inv_det;
+    out[4] = c01 * inv_det;
+    out[5] = (m[0] * m[10] - m[2] * m[8]) * inv_det;
+    out[6] = (m[2] * m[4] - m[0] * m[6]) * inv_det;
+    out[8] = c02 * inv_det;
+    out[9] = (m[1] * m[8] - m[0] * m[9]) * inv_det;
+    out[10] = (m[0] * m[5] - m[1] * m[4]) * inv_det;
+
+    out[3] = -(out[0] * m[3] + out[1] * m[7] + out[2] * m[11]);
+    out[7] = -(out[4] * m[3] + out[5] * m[7] + out[6] * m[11]);
+    out[11] = -(out[8] * m[3] + out[9] * m[7] + out[10] * m[11]);
+
+    out[12] = 0;
+    out[13] = 0;
+    out[14] = 0;
+    out[15] = 1;
+};
+
+static void inverse_4x4(const float *m, float *out) {
+    if (is_affine_4x4(m)) {
+        inverse_affine_4x4(m, out);
+        return;
+    };
+    float s0 = m[0] * m[5] - m[1] * m[4];
+    float s1 = m[0] * m[6] - m[2] * m[4];
+    float s2 = m[0] * m[7] - m[3] * m[4];
+    float s3 = m[1] * m[6] - m[2] * m[5];
+    float s4 = m[1] * m[7] - m[3] * m[5];
+    float s5 = m[2] * m[7] - m[3] * m[6];
+
+    float c5 = m[10] * m[15] - m[11] * m[14];
+    float c4 = m[9] * m[15] - m[11] * m[13];
+    float c3 = m[9] * m[14] - m[10] * m[13];
+    float c2 = m[8] * m[15] - m[11] * m[12];
+    float c1 = m[8] * m[14] - m[10] * m[12];
+    float c0 = m[8] * m[13] - m[9] * m[12];
+
+    float inv_det = 1 / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    out[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inv_det;
+    out[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inv_det;
+    out[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inv_det;
+    out[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inv_det;
+
+    out[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inv_det;
+    out[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inv_det;
+    out[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inv_det;
+    out[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inv_det;
+
+    out[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inv_det;
+    out[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inv_det;
+    out[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inv_det;
+    out[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inv_det;
+
+    out[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inv_det;
+    out[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inv_det;
+    out[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inv_det;
+    out[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inv_det;
+};
+
+template <unsigned int N>
+FixedMatrix<N>::FixedMatrix(const Matrix &m) {
+    if (m.get_row_count() != N || m.get_column_count() != N) {
+        throw std::invalid_argument("Matrix dimensions do not match the fixed matrix size.");
+    };
+    const std::vector<float> &data = m.get_matrix_data();
+    for (unsigned int i = 0; i < N * N; i++) {
+        data_[i] = data[i];
+    };
+};
+
+template <unsigned int N>
+FixedMatrix<N> FixedMatrix<N>::transpose() const {
+    FixedMatrix result;
+    for (unsigned int i = 0; i < N; i++) {
+        for (unsigned int j = 0; j < N; j++) {
+            result.data_[j * N + i] = data_[i * N + j];
+        };
+    };
+    return result;
+};
+
+template <unsigned int N>
+float FixedMatrix<N>::determinant() const {
+    if constexpr (N == 1) {
+        return data_[0];
+    } else if constexpr (N == 4) {
+        return determinant_4x4(data_);
+    } else if constexpr (N == 2) {
+        return data_[0] * data_[3] - data_[1] * data_[2];
+    } else {
+        float det = 0;
+        for (unsigned int i = 0; i < N; i++) {
+            det += data_[i] * cofactor(0, i);
+        };
+        return det;
+    };
+};
+
+template <unsigned int N>
+FixedMatrix<N - 1> FixedMatrix<N>::submatrix(unsigned int row, unsigned int col) const requires (N > 1) {
+    FixedMatrix<N - 1> result;
+    unsigned int r = 0;
+    for (unsigned int i = 0; i < N; i++) {
+        if (i == row) {
+            continue;
+        };
+        unsigned int c = 0;
+        for (unsigned int j = 0; j < N; j++) {
+            if (j == col) {
+                continue;
+            };
+            result.set_point(r, c, data_[i * N + j]);
+            c++;
+        };
+        r++;
+    };
+    return result;
+};
+
+template <unsigned int N>
+float FixedMatrix<N>::minor(unsigned int row, unsigned int col) const requires (N > 1) {
+    return submatrix(row, col).determinant();
+};
+
+template <unsigned int N>
+float FixedMatrix<N>::cofactor(unsigned int row, unsigned int col) const requires (N > 1) {
+    return ((row + col) % 2 == 1) ? -minor(row, col) : minor(row, col);
+};
+
+template <unsigned int N>
+FixedMatrix<N> FixedMatrix<N>::inverse() const {
+    if constexpr (N == 4) {
+        FixedMatrix result;
+        inverse_4x4(data_, result.data_);
+        return result;
+    };
+    float inverted_determinant = 1 / determinant();
+    if constexpr (N == 1) {
+        FixedMatrix result;
+        result.data_[0] = inverted_determinant;
+        return result;
+    } else {
+        // Transposed cofactor matrix, scaled by 1 / determinant
+        FixedMatrix result;
+        for (unsigned int i = 0; i < N; i++) {
+            for (unsigned int j = 0; j < N; j++) {
+                result.data_[j * N + i] = cofactor(i, j) * inverted_determinant;
+            };
+        };
+        return result;
+    };
+};
+
+template <unsigned int N>
+bool FixedMatrix<N>::is_invertible() const {
+    return determinant() != 0;
+};
+
+template <unsigned int N>
+Matrix FixedMatrix<N>::to_matrix() const {
+    return Matrix(N, N, std::vector<float>(data_, data_ + N * N));
+};
+
+template <unsigned int N>
+std::string FixedMatrix<N>::to_string() const {
+    std::string val;
+    for (unsigned int i = 0; i < N * N; i++) {
+        if (i % N == 0 && i != 0) {
+            val += "\n";
+        };
+        val += std::to_string(data_[i]) + " ";
+    };
+    return val;
+};
+
+template class FixedMatrix<1>;
+template class FixedMatrix<2>;
+template class FixedMatrix<3>;
+template class FixedMatrix<4>;
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "tuple.h"
+#include "matrix.h"
+
+#include <array>
+#include <string>
+#include <ostream>
+
+
+// Fixed-size square matrices with inline storage.
+// The generic Matrix class heap-allocates on every operation, so the
+// render path (shapes, rays, camera, patterns) uses these instead. No
+// bounds checking is done on element access.
+template <unsigned int N>
+class FixedMatrix {
+    static_assert(N >= 1, "FixedMatrix must be at least 1x1.");
+    private:
+        float data_[N * N];
+    public:
+        // Methods
+        FixedMatrix() {
+            for (unsigned int i = 0; i < N * N; i++) {
+                data_[i] = (i % (N + 1) == 0) ? 1 : 0;
+            };
+        };
+        FixedMatrix(const std::array<float, N * N> &data) {
+            for (unsigned int i = 0; i < N * N; i++) {
+                data_[i] = data[i];
+            };
+        };
+        // Implicit so that the chapter 4 transform functions can be used
+        // anywhere a fixed-size matrix is expected.
+        FixedMatrix(const Matrix &m);
+        float get_point(unsigned int row, unsigned int col) const {
+            return data_[row * N + col];
+        };
+        void set_point(unsigned int row, unsigned int col, float value) {
+            data_[row * N + col] = value;
+        };
+        const float * get_matrix_data() const {
+            return data_;
+        };
+        FixedMatrix transpose() const;
+        float determinant() const;
+        float minor(unsigned int row, unsigned int col) const requires (N > 1);
+        FixedMatrix<N - 1> submatrix(unsigned int row, unsigned int col) const requires (N > 1);
+        float cofactor(unsigned int row, unsigned int col) const requires (N > 1);
+        FixedMatrix inverse() const;
+        bool is_invertible() const;
+        Matrix to_matrix() const;
+        std::string to_string() const;
+
+        // Arithmetic operators
+        friend bool operator==(const FixedMatrix &lhs, const FixedMatrix &rhs) {
+            for (unsigned int i = 0; i < N * N; i++) {
+                if (!equalByEpsilon(lhs.data_[i], rhs.data_[i])) {
+                    return false;
+                };
+            };
+            return true;
+        };
+
+        friend bool operator!=(const FixedMatrix &lhs, const FixedMatrix &rhs) {
+            return !(lhs == rhs);
+        };
+
+        friend FixedMatrix operator*(const FixedMatrix &lhs, const FixedMatrix &rhs) {
+            FixedMatrix result;
+            for (unsigned int i = 0; i < N; i++) {
+                for (unsigned int j = 0; j < N; j++) {
+                    float sum = 0;
+                    for (unsigned int k = 0; k < N; k++) {
+                        sum += lhs.data_[i * N + k] * rhs.data_[k * N + j];
+                    };
+                    result.data_[i * N + j] = sum;
+                };
+            };
+            return result;
+        };
+
+        friend FixedMatrix operator*(const FixedMatrix &m, float f) {
+            FixedMatrix result;
+            for (unsigned int i = 0; i < N * N; i++) {
+                result.data_[i] = m.data_[i] * f;
+            };
+            return result;
+        };
+
+        friend void PrintTo(const FixedMatrix &m, std::ostream *os) {
+            *os << m.to_string();
+        };
+};
+
+using Matrix4 = FixedMatrix<4>;
+using Matrix3 = FixedMatrix<3>;
+using Matrix2 = FixedMatrix<2>;
+
+inline Tuple operator*(const Matrix4 &m, const Tuple &t) {
+    const float *d = m.get_matrix_data();
+    return Tuple(
+        d[0]  * t.x + d[1]  * t.y + d[2]  * t.z + d[3]  * t.w,
+        d[4]  * t.x + d[5]  * t.y + d[6]  * t.z + d[7]  * t.w,
+        d[8]  * t.x + d[9]  * t.y + d[10] * t.z + d[11] * t.w,
+        d[12] * t.x + d[13] * t.y + d[14] * t.z + d[15] * t.w
+    );
+};
+
+extern template class FixedMatrix<1>;
+extern template class FixedMatrix<2>;
+extern template class FixedMatrix<3>;
+extern template class FixedMatrix<4>;
@@ -8,31 +8,33 @@
 
 
 Intersection::Intersection() {
+    this->t = 0;
+    this->object = NULL;
     this->empty = true;
 };
 
-Intersection::Intersection(float t, Shape *const obj) {
+Intersection::Intersection(float t, const Shape *obj) {
     this->t = t;
     this->object = obj;
     this->empty = false;
 };
 
-bool Intersection::is_empty() {
+bool Intersection::is_empty() const {
     return empty;
 };
 
-bool operator==(Intersection lhs, Intersection rhs) {
+bool operator==(const Intersection &lhs, const Intersection &rhs) {
     return (
         lhs.object == rhs.object &&
         lhs.t == rhs.t
     );
 };
 
-bool operator<(Intersection lhs, Intersection rhs) {
+bool operator<(const Intersection &lhs, const Intersection &rhs) {
     return lhs.t < rhs.t;
 };
 
-Computation Intersection::prepare_computations(Ray r) {
+Computation Intersection::prepare_computations(const Ray &r) const {
     Tuple point = r.position(t);
     Tuple eyev = -r.get_direction();
     Tuple normalv = (*object).normal_at(point);
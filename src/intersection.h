@@ -11,13 +11,13 @@ class Intersection {
         bool empty;
     public:
         Intersection();
-        Intersection(float t, Shape *const obj);
+        Intersection(float t, const Shape *obj);
         float t;
         // TODO: use OOP to generalize this object class
-        Shape *object;
-        bool is_empty();
-        Computation prepare_computations(Ray r);
+        const Shape *object;
+        bool is_empty() const;
+        Computation prepare_computations(const Ray &r) const;
 };
 
-bool operator==(Intersection lhs, Intersection rhs);
-bool operator<(Intersection lhs, Intersection rhs);
+bool operator==(const Intersection &lhs, const Intersection &rhs);
+bool operator<(const Intersection &lhs, const Intersection &rhs);
@@ -1,23 +1,146 @@
 #include <vector>
 #include <stdexcept>
+#include <utility>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <initializer_list>
 
 #include "intersection.h"
 #include "intersections.h"
 #include "sphere.h"
 #include "ray.h"
+#include "arena.h"
 
 
+// Arena storage is never destructed
+static_assert(std::is_trivially_destructible<Intersection>::value,
+    "Intersection must be trivially destructible to live in an Arena.");
 
-Intersections::Intersections(std::vector<Intersection> data) {
-    this->data = data;
-    this->count = data.size();
+Intersections::Intersections() {
+    this->count = 0;
+    this->spill = NULL;
+    this->spill_capacity = 0;
+    this->spill_in_arena = false;
 };
 
-Intersection Intersections::operator[](int i) {
-    return data[i];
+Intersections::Intersections(const std::vector<Intersection> &data) : Intersections() {
+    for (const Intersection &i : data) {
+        push_back(i);
+    };
+};
+
+Intersections::Intersections(std::initializer_list<Intersection> data) : Intersections() {
+    for (const Intersection &i : data) {
+        push_back(i);
+    };
+};
+
+Intersections::Intersections(const Intersections &other) : Intersections() {
+    *this = other;
+};
+
+Intersections::Intersections(Intersections &&other) noexcept : Intersections() {
+    *this = std::move(other);
+};
+
+Intersections &Intersections::operator=(const Intersections &other) {
+    if (this != &other) {
+        clear();
+        append(other);
+    };
+    return *this;
+};
+
+Intersections &Intersections::operator=(Intersections &&other) noexcept {
+    if (this != &other) {
+        release_spill();
+        if (other.is_inline()) {
+            std::copy(other.begin(), other.end(), inline_data);
+        } else {
+            spill = other.spill;
+            spill_capacity = other.spill_capacity;
+            spill_in_arena = other.spill_in_arena;
+            other.spill = NULL;
+            other.spill_capacity = 0;
+        };
+        count = other.count;
+        other.clear();
+    };
+    return *this;
+};
+
+Intersections::~Intersections() {
+    release_spill();
+};
+
+void Intersections::release_spill() {
+    if (spill != NULL && !spill_in_arena) {
+        delete[] spill;
+    };
+    spill = NULL;
+    spill_capacity = 0;
+    spill_in_arena = false;
+};
+
+Intersection * Intersections::entries() {
+    return is_inline() ? inline_data : spill;
+};
+
+bool Intersections::is_inline() const {
+    return spill == NULL;
+};
+
+void Intersections::push_back(const Intersection &i) {
+    if (count < inline_capacity && spill == NULL) {
+        inline_data[count++] = i;
+        return;
+    };
+    if (count == spill_capacity || spill == NULL) {
+        // Spill, or grow the spill: from here on every entry lives in it
+        int capacity = std::max(2 * count, 2 * inline_capacity);
+        Arena *arena = Arena::current();
+        Intersection *grown = arena != NULL
+            ? arena->allocate_array<Intersection>(capacity)
+            : new Intersection[capacity];
+        std::uninitialized_copy(begin(), end(), grown);
+        release_spill();
+        spill = grown;
+        spill_capacity = capacity;
+        spill_in_arena = arena != NULL;
+    };
+    new (&spill[count++]) Intersection(i);
+};
+
+void Intersections::append(const Intersections &other) {
+    for (const Intersection &i : other) {
+        push_back(i);
+    };
+};
+
+void Intersections::clear() {
+    release_spill();
+    count = 0;
+};
+
+void Intersections::sort() {
+    std::sort(entries(), entries() + count);
+};
+
+const Intersection *Intersections::begin() const {
+    return is_inline() ? inline_data : spill;
+};
+
+const Intersection *Intersections::end() const {
+    return begin() + count;
+};
+
+const Intersection &Intersections::operator[](int i) const {
+    return begin()[i];
 };
 
-Intersection Intersections::hit() {
+Intersection Intersections::hit() const {
     if (count == 0) {
         // TODO: Think about other ways you could avoid throwing this if this causes issues in the future.
         // return null intersection?
@@ -25,6 +148,7 @@ Intersection Intersections::hit() {
         return Intersection();
     };
     
+    const Intersection *data = begin();
     Intersection inter = data[0];
 
     for (int i=0; i<count; i++) {
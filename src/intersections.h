@@ -1,16 +1,47 @@
 #pragma once
 
 #include <vector>
+#include <initializer_list>
 #include "ray.h"
 #include "intersection.h"
 
 
+// A list of intersections that keeps the first inline_capacity entries
+// inside the object and only spills to separate storage beyond that.
+// Shapes and typical worlds never get that far, so building, copying and
+// returning an Intersections normally allocates nothing. When a spill does
+// happen on a render thread it is served from the thread's Arena, so it
+// must not outlive the tile being rendered; elsewhere it uses the heap.
 class Intersections {
     public:
-        Intersections() : Intersections(std::vector<Intersection>{}) {};
-        Intersections(std::vector<Intersection>);
-        std::vector<Intersection> data;
+        static const int inline_capacity = 8;
+    private:
+        Intersection inline_data[inline_capacity];
+        // Holds every entry once the list has outgrown inline_data
+        Intersection * spill;
+        int spill_capacity;
+        // Arena storage is released with the arena, not by this list
+        bool spill_in_arena;
+        Intersection * entries();
+        void release_spill();
+    public:
+        Intersections();
+        Intersections(const std::vector<Intersection> &);
+        Intersections(std::initializer_list<Intersection>);
+        Intersections(const Intersections &);
+        Intersections(Intersections &&) noexcept;
+        Intersections &operator=(const Intersections &);
+        Intersections &operator=(Intersections &&) noexcept;
+        ~Intersections();
         int count;
-        Intersection operator[](int);
-        Intersection hit();
+        void push_back(const Intersection &);
+        void append(const Intersections &);
+        void clear();
+        // Orders the entries by t
+        void sort();
+        bool is_inline() const;
+        const Intersection *begin() const;
+        const Intersection *end() const;
+        const Intersection &operator[](int) const;
+        Intersection hit() const;
 };
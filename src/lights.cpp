@@ -5,14 +5,14 @@
 
 
 // Chapter 6: Lights and Shading
-PointLight::PointLight(Tuple position, Color intensity) {
+PointLight::PointLight(const Tuple &position, const Color &intensity) {
     this->position = position;
     this->intensity = intensity;    
 };
 
-Tuple PointLight::get_position() {
+const Tuple &PointLight::get_position() const {
     return position;
 };
-Color PointLight::get_intensity() {
+const Color &PointLight::get_intensity() const {
     return intensity;
 };
@@ -9,7 +9,7 @@ class PointLight {
         Tuple position;
         Color intensity;
     public:
-        PointLight(Tuple position, Color intensity);
-        Tuple get_position();
-        Color get_intensity();
+        PointLight(const Tuple &position, const Color &intensity);
+        const Tuple &get_position() const;
+        const Color &get_intensity() const;
 };
@@ -4,7 +4,7 @@
 // Chapter 6: Lights and Shading
 Material::Material(
     StripePattern * pattern,
-    Color color,
+    const Color &color,
     float ambient,
     float diffuse,
     float specular,
@@ -18,7 +18,7 @@ Material::Material(
     this->shininess = shininess;
 };
 
-std::string Material::to_string() {
+std::string Material::to_string() const {
     return "Material(Color=" + color.to_string() +
         ", Ambient=" + std::to_string(ambient) +
         ", Diffuse=" + std::to_string(diffuse) +
@@ -27,21 +27,32 @@ std::string Material::to_string() {
 };
 
 Color Material::lighting(
-    Shape * object,
-    PointLight light,
-    Tuple position,
-    Tuple eyev,
-    Tuple normalv,
+    const Shape * object,
+    const PointLight &light,
+    const Tuple &position,
+    const Tuple &eyev,
+    const Tuple &normalv,
     bool in_shadow
-) {
-    Color black = Color();
-    Color base_color;
+) const {
+    return lighting(base_color_at(object, position), light, position, eyev, normalv, in_shadow);
+};
 
+Color Material::base_color_at(const Shape * object, const Tuple &position) const {
     if (this->pattern != NULL) {
-        base_color = (*this->pattern).stripe_at_object(object, position);
-    } else {
-        base_color = this->color;
-    }
+        return (*this->pattern).stripe_at_object(object, position);
+    };
+    return this->color;
+};
+
+Color Material::lighting(
+    const Color &base_color,
+    const PointLight &light,
+    const Tuple &position,
+    const Tuple &eyev,
+    const Tuple &normalv,
+    bool in_shadow
+) const {
+    Color black = Color();
     Color effective_color = base_color * light.get_intensity();
     Tuple lightv = (light.get_position() - position).normalize();
 
@@ -74,7 +85,7 @@ Color Material::lighting(
 };
 
 // Arithmetic operators
-bool operator==(Material lhs, Material rhs) {
+bool operator==(const Material &lhs, const Material &rhs) {
     return (
         (lhs.pattern == rhs.pattern) &&
         (lhs.color == rhs.color) &&
@@ -12,14 +12,14 @@ class Material {
     public:
         Material(
             StripePattern * pattern = NULL,
-            Color color = Color(1, 1, 1),
+            const Color &color = Color(1, 1, 1),
             float ambient = 0.1,
             float diffuse = 0.9,
             float specular = 0.9,
             float shininess = 200.0
         );
         Material(
-            Color color,
+            const Color &color,
             float ambient,
             float diffuse,
             float specular,
@@ -38,15 +38,27 @@ class Material {
         float diffuse;
         float specular;
         float shininess;
-        std::string to_string();
+        std::string to_string() const;
         Color lighting(
-            Shape * object,
-            PointLight light,
-            Tuple position,
-            Tuple eyev,
-            Tuple normalv,
+            const Shape * object,
+            const PointLight &light,
+            const Tuple &position,
+            const Tuple &eyev,
+            const Tuple &normalv,
             bool in_shadow
-        );
+        ) const;
+        // The surface colour at a point, from the pattern if there is one
+        Color base_color_at(const Shape * object, const Tuple &position) const;
+        // lighting() with the surface colour already looked up, so that it
+        // is done once per hit rather than once per light
+        Color lighting(
+            const Color &base_color,
+            const PointLight &light,
+            const Tuple &position,
+            const Tuple &eyev,
+            const Tuple &normalv,
+            bool in_shadow
+        ) const;
 };
 
-bool operator==(Material lhs, Material rhs);
\ No newline at end of file
+bool operator==(const Material &lhs, const Material &rhs);
\ No newline at end of file
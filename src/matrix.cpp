@@ -1,5 +1,6 @@
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include <vector>
 #include <numeric>
 // TODO: remove
@@ -9,6 +10,7 @@
 
 #include <stdexcept>
 #include <algorithm>
+#include <utility>
 
 // Chapter 3: Matrix Math
 Matrix::Matrix(unsigned int rows, unsigned int columns, std::vector<float> data) {
@@ -17,25 +19,25 @@ Matrix::Matrix(unsigned int rows, unsigned int columns, std::vector<float> data)
     };
     rows_ = rows;
     columns_ = columns;
-    data_ = data;
+    data_ = std::move(data);
 };
 
 // Matrix(unsigned int rows, unsigned int columns, float data[]);
-float Matrix::get_point(unsigned int row, unsigned int col) {
+float Matrix::get_point(unsigned int row, unsigned int col) const {
     check_valid_row_coord(row);
     check_valid_column_coord(col);
     return data_[row * columns_ + col];
 };
 
 
-std::vector<float> Matrix::get_row(unsigned int row) {
+std::vector<float> Matrix::get_row(unsigned int row) const {
     check_valid_row_coord(row);
     int start_index = row * columns_;
     int end_index = start_index + columns_;
     return std::vector<float>(data_.begin() + start_index, data_.begin() + end_index);
 };
 
-std::vector<float> Matrix::get_column(unsigned int col) {
+std::vector<float> Matrix::get_column(unsigned int col) const {
     check_valid_column_coord(col);
     std::vector<float> col_vector;
     for (int i=0;i<data_.size();i++) {
@@ -47,26 +49,25 @@ std::vector<float> Matrix::get_column(unsigned int col) {
 };
 
 
-unsigned int Matrix::get_row_count() {
+unsigned int Matrix::get_row_count() const {
     return rows_;
 };
 
-unsigned int Matrix::get_column_count() {
+unsigned int Matrix::get_column_count() const {
     return columns_;
 };
 
-std::vector<float> Matrix::get_matrix_data() {
-    std::vector<float> copy = data_;
-    return copy;
+const std::vector<float> &Matrix::get_matrix_data() const {
+    return data_;
 };
 
 // Arithmetic operator overloads
-bool operator==(Matrix lhs, Matrix rhs) {
+bool operator==(const Matrix &lhs, const Matrix &rhs) {
     if (lhs.get_row_count() != rhs.get_row_count() || lhs.get_column_count() != rhs.get_column_count()) {
         return false;
     };
-    std::vector<float> lhs_data = lhs.get_matrix_data();
-    std::vector<float> rhs_data = rhs.get_matrix_data();
+    const std::vector<float> &lhs_data = lhs.get_matrix_data();
+    const std::vector<float> &rhs_data = rhs.get_matrix_data();
     for (int i=0; i<lhs_data.size(); i++) {
         if (!equalByEpsilon(lhs_data[i], rhs_data[i])) {
             return false;
@@ -75,11 +76,11 @@ bool operator==(Matrix lhs, Matrix rhs) {
     return true;
 };
 
-bool operator!=(Matrix lhs, Matrix rhs) {
+bool operator!=(const Matrix &lhs, const Matrix &rhs) {
     return !operator==(lhs, rhs);
 };
 
-Matrix operator*(Matrix lhs, Matrix rhs) {
+Matrix operator*(const Matrix &lhs, const Matrix &rhs) {
     unsigned int new_rows = lhs.get_row_count();
     unsigned int new_cols = rhs.get_column_count();
     std::vector<float> new_data;
@@ -95,7 +96,7 @@ Matrix operator*(Matrix lhs, Matrix rhs) {
     return Matrix(new_rows, new_cols, new_data);
 };
 
-Tuple operator*(Matrix m, Tuple t) {
+Tuple operator*(const Matrix &m, const Tuple &t) {
     if (m.get_row_count() != 4 || m.get_column_count() != 4) {
         throw std::invalid_argument("Unfit matrix: Matrix must be 4x4 to multiply with a tuple.");
     };
@@ -108,8 +109,8 @@ Tuple operator*(Matrix m, Tuple t) {
     );
 };
 
-Matrix operator*(Matrix m, float x) {
-    std::vector<float> input = m.get_matrix_data();
+Matrix operator*(const Matrix &m, float x) {
+    const std::vector<float> &input = m.get_matrix_data();
     std::vector<float> output;
     for (int i=0; i<input.size(); i++) {
         output.push_back(input[i] * x);
@@ -119,7 +120,7 @@ Matrix operator*(Matrix m, float x) {
 
 
 
-float dot_product(std::vector<float> v1, std::vector<float> v2) {
+float dot_product(const std::vector<float> &v1, const std::vector<float> &v2) {
     if (v1.size() != v2.size()) {
         throw std::invalid_argument("Length of vector 1 does not match length of vector 2");
     };
@@ -131,14 +132,14 @@ float dot_product(std::vector<float> v1, std::vector<float> v2) {
     );
 };
 
-void Matrix::check_valid_row_coord(unsigned int row_coord) {
+void Matrix::check_valid_row_coord(unsigned int row_coord) const {
     if (row_coord >= rows_) {
         throw std::invalid_argument("Row coordinate out of range of matrix");
     };
     return;
 };
 
-void Matrix::check_valid_column_coord(unsigned int column_coord) {
+void Matrix::check_valid_column_coord(unsigned int column_coord) const {
     if (column_coord >= columns_) {
         throw std::invalid_argument("Column coordinate out of range of matrix");
     };
@@ -159,7 +160,7 @@ std::ostream& operator<<(std::ostream& os,
 };
 
 
-Matrix Matrix::transpose() {
+Matrix Matrix::transpose() const {
     std::vector<float> new_data;
     std::vector<float> current_col;
     for (int i = 0;i < columns_; i++) {
@@ -173,7 +174,7 @@ Matrix Matrix::transpose() {
     return Matrix(columns_, rows_, new_data);
 };
 
-Matrix Matrix::cofactor_matrix() {
+Matrix Matrix::cofactor_matrix() const {
     if (get_row_count() == 1 && get_column_count() == 1) {
         std::vector<float> id_data = {1};
         return Matrix(1, 1, id_data);
@@ -188,7 +189,10 @@ Matrix Matrix::cofactor_matrix() {
     return Matrix(rows_, columns_, cofactor_input);
 };
 
-Matrix Matrix::inverse() {
+Matrix Matrix::inverse() const {
+    if (rows_ == 4 && columns_ == 4) {
+        return Matrix4(*this).inverse().to_matrix();
+    };
     Matrix cofactor_mat = cofactor_matrix();
     Matrix transposed_cofactors = cofactor_mat.transpose();
     float inverted_determinant = 1 / determinant();
@@ -196,12 +200,16 @@ Matrix Matrix::inverse() {
     return transposed_cofactors * inverted_determinant;
 };
 
-float Matrix::determinant() {
+float Matrix::determinant() const {
     if (!is_square()) {
         throw std::invalid_argument("Row coordinate out of range of matrix");
     };
     float det = 0;
 
+    if (get_column_count() == 4 && get_row_count() == 4) {
+        return Matrix4(*this).determinant();
+    };
+
     if (get_column_count() == 1 && get_row_count() == 1) {
         return get_point(0, 0);
     };
@@ -217,15 +225,15 @@ float Matrix::determinant() {
     return det;
 };
 
-float Matrix::minor(unsigned int row, unsigned int col) {
+float Matrix::minor(unsigned int row, unsigned int col) const {
     return submatrix(row, col).determinant();
 };
 
-float Matrix::cofactor(unsigned int row, unsigned int col) {
+float Matrix::cofactor(unsigned int row, unsigned int col) const {
     return ((row + col) % 2 == 1) ? -minor(row, col) : minor(row, col);
 };
 
-Matrix Matrix::submatrix(unsigned int row, unsigned int col) {
+Matrix Matrix::submatrix(unsigned int row, unsigned int col) const {
     std::vector<float> new_data;
     for (int i=0; i < rows_; i++) {
         for (int j=0; j < columns_; j++) {
@@ -237,15 +245,15 @@ Matrix Matrix::submatrix(unsigned int row, unsigned int col) {
     return Matrix(rows_ - 1, columns_ - 1, new_data);
 };
 
-bool Matrix::is_square() {
+bool Matrix::is_square() const {
     return rows_ == columns_;
 };
 
-bool Matrix::is_invertible() {
+bool Matrix::is_invertible() const {
     return determinant() != 0;
 };
 
-std::string Matrix::to_string() {
+std::string Matrix::to_string() const {
     std::string val;
     for (int i=0; i < get_elements_count() ; i++) {
         if (i % columns_ == 0 && i != 0) {
@@ -256,7 +264,7 @@ std::string Matrix::to_string() {
     return val;
 };
 
-unsigned int Matrix::get_elements_count() {
+unsigned int Matrix::get_elements_count() const {
     return rows_ * columns_;
 };
 
@@ -273,6 +281,5 @@ Matrix identity_matrix(int size) {
 // Chapter 7: Making a Scene
 // Defining a view transform
 void PrintTo(const Matrix& m, std::ostream* os) {
-    Matrix& ref = const_cast <Matrix&>(m);
-    *os << ref.to_string();
+    *os << m.to_string();
 }
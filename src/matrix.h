@@ -11,9 +11,9 @@ class Matrix {
         unsigned int rows_;
         unsigned int columns_;
         std::vector<float> data_;
-        void check_valid_row_coord(unsigned int row_coord);
-        void check_valid_column_coord(unsigned int column_coord);
-        Matrix cofactor_matrix();
+        void check_valid_row_coord(unsigned int row_coord) const;
+        void check_valid_column_coord(unsigned int column_coord) const;
+        Matrix cofactor_matrix() const;
     public:
         // Methods
         Matrix(
@@ -23,34 +23,34 @@ class Matrix {
                                                           0, 1, 0, 0,
                                                           0, 0, 1, 0,
                                                           0, 0, 0, 1});
-        float get_point(unsigned int row, unsigned int col);
-        std::vector<float> get_row(unsigned int row);
-        std::vector<float> get_column(unsigned int col);
-        unsigned int get_row_count();
-        unsigned int get_column_count();
-        unsigned int get_elements_count();
-        std::vector<float> get_matrix_data();
-        Matrix transpose();
-        float determinant();
-        float minor(unsigned int row, unsigned int col);
-        Matrix submatrix(unsigned int row, unsigned int col);
-        float cofactor(unsigned int row, unsigned int col);
-        Matrix inverse();
-        bool is_square();
-        bool is_invertible();
-        std::string to_string();
+        float get_point(unsigned int row, unsigned int col) const;
+        std::vector<float> get_row(unsigned int row) const;
+        std::vector<float> get_column(unsigned int col) const;
+        unsigned int get_row_count() const;
+        unsigned int get_column_count() const;
+        unsigned int get_elements_count() const;
+        const std::vector<float> &get_matrix_data() const;
+        Matrix transpose() const;
+        float determinant() const;
+        float minor(unsigned int row, unsigned int col) const;
+        Matrix submatrix(unsigned int row, unsigned int col) const;
+        float cofactor(unsigned int row, unsigned int col) const;
+        Matrix inverse() const;
+        bool is_square() const;
+        bool is_invertible() const;
+        std::string to_string() const;
 };
 
 // Arithmetic Operators
-bool operator==(Matrix lhs, Matrix rhs);
-bool operator!=(Matrix lhs, Matrix rhs);
-Matrix operator*(Matrix lhs, Matrix rhs);
-Tuple operator*(Matrix m, Tuple t);
-Matrix operator*(Matrix m, float f);
+bool operator==(const Matrix &lhs, const Matrix &rhs);
+bool operator!=(const Matrix &lhs, const Matrix &rhs);
+Matrix operator*(const Matrix &lhs, const Matrix &rhs);
+Tuple operator*(const Matrix &m, const Tuple &t);
+Matrix operator*(const Matrix &m, float f);
 
 // Helpful functions
 // TODO: Find if there's a better way to use this 
-float dot_product(std::vector<float> v1, std::vector<float> v2);
+float dot_product(const std::vector<float> &v1, const std::vector<float> &v2);
 Matrix identity_matrix(int size);
 
 // Chapter 7: Making a Scene
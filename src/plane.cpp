@@ -1,22 +1,68 @@
 #include "plane.h"
 #include "intersection.h"
 
+#include <limits>
+
 // Chapter 9: Planes
-Tuple Plane::local_normal_at(float x, float y, float z) {
+Tuple Plane::local_normal_at(float x, float y, float z) const {
     return local_normal_at(point(x, y, z));
 };
 
-Tuple Plane::local_normal_at(Tuple p) {
+Tuple Plane::local_normal_at(const Tuple &p) const {
     return normal;
 };
 
 // TODO: refactor when an intersection is done on a general "object" class
 // rather than just the sphere class.
-Intersections Plane::local_intersect(Ray r) {
+Intersections Plane::local_intersect(const Ray &r) const {
+    Intersections xs;
+    local_intersect_into(r, xs);
+    return xs;
+};
+
+void Plane::local_intersect_into(const Ray &r, Intersections &xs) const {
     if (std::abs(r.get_direction().y) < 0.0001) {
-        return Intersections();  // no intersections
+        return;  // no intersections
     };
     float t = - (r.get_origin().y) / r.get_direction().y;
-    Intersection i = Intersection(t, this);
-    return Intersections(std::vector<Intersection> {i});
-};
\ No newline at end of file
+    xs.push_back(Intersection(t, this));
+};
+
+bool Plane::local_nearest_hit(const Ray &r, float t_max, float &t) const {
+    return xz_plane_hit(r.get_origin(), r.get_direction(), t_max, t);
+};
+
+bool Plane::xz_plane_hit(const Tuple &origin, const Tuple &direction, float t_max, float &t) {
+    if (std::abs(direction.y) < 0.0001) {
+        return false;
+    };
+    float t_plane = - (origin.y) / direction.y;
+    if (t_plane >= 0 && t_plane < t_max) {
+        t = t_plane;
+        return true;
+    };
+    return false;
+};
+
+// Same test as local_nearest_hit, without branches across the lanes
+void Plane::local_nearest_hits(const RayPacket &r, PacketHits &hits) const {
+    const unsigned int n = RayPacket::size;
+    float t_lane[n];
+    bool hit[n];
+    for (unsigned int i = 0; i < n; i++) {
+        float t = - r.oy[i] / r.dy[i];
+        t_lane[i] = t;
+        hit[i] = std::abs(r.dy[i]) >= 0.0001 && t >= 0 && t < hits.t[i];
+    };
+    for (unsigned int i = 0; i < n; i++) {
+        if (hit[i] && r.is_active(i)) {
+            hits.t[i] = t_lane[i];
+            hits.object[i] = this;
+        };
+    };
+};
+
+BoundingBox Plane::local_bounds() const {
+    float inf = std::numeric_limits<float>::infinity();
+    return BoundingBox(point(-inf, 0, -inf), point(inf, 0, inf));
+};
@@ -2,6 +2,7 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "material.h"
 #include "intersection.h"
@@ -21,15 +22,22 @@ class Plane : public Shape {
         Tuple point_inside;
     public:
         // Methods
-        Plane(Matrix t = identity_matrix(4), Material m = Material()) : Shape(t, m) {
+        Plane(const Matrix4 &t = Matrix4(), const Material &m = Material()) : Shape(t, m) {
             this->normal = vector(0, 1, 0);
             this->point_inside = point(0, 0, 0);
         };
-        Tuple local_normal_at(float x, float y, float z);
-        Tuple local_normal_at(Tuple p);
+        Tuple local_normal_at(float x, float y, float z) const;
+        Tuple local_normal_at(const Tuple &p) const;
         // TODO: refactor when an intersection is done on a general "object" class
         // rather than just the sphere class.
-        Intersections local_intersect(Ray r);
+        Intersections local_intersect(const Ray &r) const;
+        void local_intersect_into(const Ray &r, Intersections &xs) const;
+        bool local_nearest_hit(const Ray &r, float t_max, float &t) const;
+        // The test behind local_nearest_hit for an object-space ray, callable
+        // without a Plane or a virtual call
+        static bool xz_plane_hit(const Tuple &origin, const Tuple &direction, float t_max, float &t);
+        void local_nearest_hits(const RayPacket &r, PacketHits &hits) const;
+        BoundingBox local_bounds() const;
 };
 
 // bool operator==(Plane lhs, Plane rhs);
@@ -0,0 +1,338 @@
+#include "png.h"
+
+#include <array>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <algorithm>
+
+
+// Checksums
+static std::array<uint32_t, 256> make_crc_table() {
+    std::array<uint32_t, 256> table;
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        };
+        table[n] = c;
+    };
+    return table;
+};
+
+uint32_t crc32(const uint8_t *data, std::size_t length, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = make_crc_table();
+    crc = ~crc;
+    for (std::size_t i = 0; i < length; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    };
+    return ~crc;
+};
+
+uint32_t adler32(const uint8_t *data, std::size_t length, uint32_t adler) {
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    while (length > 0) {
+        // 5552 is the largest block that cannot overflow before the modulo
+        std::size_t block = std::min<std::size_t>(length, 5552);
+        length -= block;
+        while (block--) {
+            a += *data++;
+            b += a;
+        };
+        a %= 65521;
+        b %= 65521;
+    };
+    return (b << 16) | a;
+};
+
+
+// Deflate
+// Writes bits least-significant first, as deflate requires
+class BitWriter {
+    private:
+        std::vector<uint8_t> &out;
+        uint32_t bits;
+        int count;
+    public:
+        BitWriter(std::vector<uint8_t> &out) : out(out), bits(0), count(0) {};
+        void write(uint32_t value, int length) {
+            bits |= value << count;
+            count += length;
+            while (count >= 8) {
+                out.push_back(bits & 0xFF);
+                bits >>= 8;
+                count -= 8;
+            };
+        };
+        // Huffman codes are defined most-significant bit first
+        void write_code(uint32_t code, int length) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; i++) {
+                reversed = (reversed << 1) | ((code >> i) & 1);
+            };
+            write(reversed, length);
+        };
+        void align() {
+            if (count > 0) {
+                out.push_back(bits & 0xFF);
+            };
+            bits = 0;
+            count = 0;
+        };
+};
+
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t distance_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static const uint8_t distance_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Fixed Huffman literal/length code (RFC 1951 section 3.2.6)
+static void write_literal(BitWriter &writer, unsigned int symbol) {
+    if (symbol < 144) {
+        writer.write_code(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        writer.write_code(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        writer.write_code(symbol - 256, 7);
+    } else {
+        writer.write_code(0xC0 + symbol - 280, 8);
+    };
+};
+
+static void write_match(BitWriter &writer, unsigned int length, unsigned int distance) {
+    int code = 28;
+    while (length_base[code] > length) {
+        code--;
+    };
+    write_literal(writer, 257 + code);
+    writer.write(length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while (distance_base[code] > distance) {
+        code--;
+    };
+    writer.write_code(code, 5);
+    writer.write(distance - distance_base[code], distance_extra[code]);
+};
+
+// Compresses one independent piece of the stream. Non-final pieces end with
+// an empty stored block so the output is byte aligned and pieces compressed
+// on different threads can simply be concatenated.
+static void deflate_chunk(const uint8_t *data, std::size_t length, bool final, std::vector<uint8_t> &out) {
+    const std::size_t window = 32768;
+    const unsigned int hash_size = 1 << 15;
+    const unsigned int max_chain = 64;
+    const unsigned int min_match = 3;
+    const unsigned int max_match = 258;
+
+    BitWriter writer(out);
+    writer.write(final ? 1 : 0, 1);
+    writer.write(1, 2);  // fixed Huffman codes
+
+    // Hash chains; prev only needs to cover positions still inside the window
+    std::vector<int64_t> head(hash_size, -1);
+    std::vector<int64_t> prev(window, -1);
+    auto hash_at = [&](std::size_t i) {
+        return ((data[i] << 10) ^ (data[i + 1] << 5) ^ data[i + 2]) & (hash_size - 1);
+    };
+    auto insert = [&](std::size_t i) {
+        if (i + min_match <= length) {
+            unsigned int h = hash_at(i);
+            prev[i & (window - 1)] = head[h];
+            head[h] = i;
+        };
+    };
+
+    std::size_t i = 0;
+    while (i < length) {
+        unsigned int best_length = 0;
+        std::size_t best_distance = 0;
+        if (i + min_match <= length) {
+            std::size_t limit = std::min<std::size_t>(max_match, length - i);
+            int64_t candidate = head[hash_at(i)];
+            unsigned int chain = 0;
+            while (candidate >= 0 && i - candidate <= window && chain++ < max_chain) {
+                unsigned int match = 0;
+                while (match < limit && data[candidate + match] == data[i + match]) {
+                    match++;
+                };
+                if (match > best_length) {
+                    best_length = match;
+                    best_distance = i - candidate;
+                    if (match == limit) {
+                        break;
+                    };
+                };
+                candidate = prev[candidate & (window - 1)];
+            };
+        };
+
+        if (best_length >= min_match) {
+            write_match(writer, best_length, best_distance);
+            for (unsigned int k = 0; k < best_length; k++) {
+                insert(i + k);
+            };
+            i += best_length;
+        } else {
+            write_literal(writer, data[i]);
+            insert(i);
+            i++;
+        };
+    };
+    write_literal(writer, 256);  // end of block
+
+    if (!final) {
+        writer.write(0, 3);  // non-final stored block
+        writer.align();
+        out.push_back(0x00);
+        out.push_back(0x00);
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+    } else {
+        writer.align();
+    };
+};
+
+static void append_u32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+};
+
+std::vector<uint8_t> zlib_compress(const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> out = {0x78, 0x01};
+    deflate_chunk(data.data(), data.size(), true, out);
+    append_u32(out, adler32(data.data(), data.size()));
+    return out;
+};
+
+
+// PNG
+static uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return a;
+    };
+    return (pb <= pc) ? b : c;
+};
+
+// Writes the filter type byte and filtered bytes for one row, choosing the
+// filter with the smallest sum of absolute (signed) outputs.
+static void filter_row(const uint8_t *row, const uint8_t *above, std::size_t stride, uint8_t *out) {
+    const int bpp = 3;
+    std::vector<uint8_t> candidate(stride);
+    long best_score = -1;
+    for (uint8_t type = 0; type < 5; type++) {
+        long score = 0;
+        for (std::size_t i = 0; i < stride; i++) {
+            int a = (i >= bpp) ? row[i - bpp] : 0;
+            int b = (above != NULL) ? above[i] : 0;
+            int c = (i >= bpp && above != NULL) ? above[i - bpp] : 0;
+            uint8_t predictor = 0;
+            switch (type) {
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = (a + b) / 2; break;
+                case 4: predictor = paeth(a, b, c); break;
+            };
+            candidate[i] = row[i] - predictor;
+            score += std::abs((int8_t) candidate[i]);
+        };
+        if (best_score < 0 || score < best_score) {
+            best_score = score;
+            out[0] = type;
+            std::copy(candidate.begin(), candidate.end(), out + 1);
+        };
+    };
+};
+
+static void append_chunk(std::vector<uint8_t> &png, const char *type, const uint8_t *data, std::size_t length) {
+    append_u32(png, length);
+    std::size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data, data + length);
+    append_u32(png, crc32(png.data() + start, length + 4));
+};
+
+std::vector<uint8_t> encode_png(
+    unsigned int width,
+    unsigned int height,
+    const std::vector<uint8_t> &rgb,
+    unsigned int threads
+) {
+    std::size_t stride = (std::size_t) width * 3;
+    std::size_t filtered_stride = stride + 1;
+
+    // Filter every row, then deflate runs of rows as independent pieces
+    std::vector<uint8_t> filtered(filtered_stride * height);
+    unsigned int piece_count = std::max(1u, std::min(threads, height));
+    std::vector<std::vector<uint8_t>> pieces(piece_count);
+    auto work = [&](unsigned int piece) {
+        unsigned int first = (std::size_t) height * piece / piece_count;
+        unsigned int last = (std::size_t) height * (piece + 1) / piece_count;
+        for (unsigned int y = first; y < last; y++) {
+            const uint8_t *above = (y > 0) ? rgb.data() + (y - 1) * stride : NULL;
+            filter_row(rgb.data() + y * stride, above, stride, filtered.data() + y * filtered_stride);
+        };
+        deflate_chunk(
+            filtered.data() + first * filtered_stride,
+            (last - first) * filtered_stride,
+            piece == piece_count - 1,
+            pieces[piece]
+        );
+    };
+
+    if (piece_count == 1) {
+        work(0);
+    } else {
+        std::vector<std::thread> pool;
+        for (unsigned int piece = 0; piece < piece_count; piece++) {
+            pool.emplace_back(work, piece);
+        };
+        for (std::thread &t : pool) {
+            t.join();
+        };
+    };
+
+    std::vector<uint8_t> idat = {0x78, 0x01};
+    for (std::vector<uint8_t> &piece : pieces) {
+        idat.insert(idat.end(), piece.begin(), piece.end());
+    };
+    append_u32(idat, adler32(filtered.data(), filtered.size()));
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+    std::vector<uint8_t> ihdr;
+    append_u32(ihdr, width);
+    append_u32(ihdr, height);
+    ihdr.push_back(8);  // bit depth
+    ihdr.push_back(2);  // colour type: RGB
+    ihdr.push_back(0);  // compression method
+    ihdr.push_back(0);  // filter method
+    ihdr.push_back(0);  // no interlacing
+    append_chunk(png, "IHDR", ihdr.data(), ihdr.size());
+    append_chunk(png, "IDAT", idat.data(), idat.size());
+    append_chunk(png, "IEND", NULL, 0);
+
+    return png;
+};
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+
+// PNG encoding without external libraries.
+// Rows are filtered (None/Sub/Up/Average/Paeth, picked per row) and then
+// deflated with LZ77 + fixed Huffman codes. With threads > 1 the rows are
+// split into chunks that are filtered and compressed in parallel, each chunk
+// ending on a byte boundary so the pieces can be concatenated into one
+// zlib stream.
+
+// 8-bit RGB pixels, row-major, width * height * 3 bytes
+std::vector<uint8_t> encode_png(
+    unsigned int width,
+    unsigned int height,
+    const std::vector<uint8_t> &rgb,
+    unsigned int threads = 1
+);
+
+// Compress data into a zlib stream (RFC 1950/1951)
+std::vector<uint8_t> zlib_compress(const std::vector<uint8_t> &data);
+
+uint32_t crc32(const uint8_t *data, std::size_t length, uint32_t crc = 0);
+uint32_t adler32(const uint8_t *data, std::size_t length, uint32_t adler = 1);
@@ -1,5 +1,6 @@
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include <vector>
 #include <string>
@@ -8,7 +9,7 @@
 
 
 // Chapter 5: Rays
-Ray::Ray(Tuple origin, Tuple direction) {
+Ray::Ray(const Tuple &origin, const Tuple &direction) {
     if (!origin.isPoint()) {
         throw std::invalid_argument("Origin Error: origin argument must be a point.");
     };
@@ -19,19 +20,18 @@ Ray::Ray(Tuple origin, Tuple direction) {
     this->direction = direction;
 };
 
-Tuple Ray::get_origin() {
+const Tuple &Ray::get_origin() const {
     return origin;
 };
 
-Tuple Ray::get_direction() {
+const Tuple &Ray::get_direction() const {
     return direction;
 };
 
-Tuple Ray::position(float t) {
+Tuple Ray::position(float t) const {
     return origin + direction * t;
 };
 
-Ray Ray::transform(Matrix m) {
-    // TODO: Add size checking code
+Ray Ray::transform(const Matrix4 &m) const {
     return Ray(m * origin, m * direction);
 };
@@ -2,6 +2,7 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 
 #include <vector>
 #include <string>
@@ -15,9 +16,9 @@ class Ray {
     public:
         // Methods
         // TODO: Create a default construction of the Ray class
-        Ray(Tuple origin, Tuple direction);
-        Tuple get_origin();
-        Tuple get_direction();
-        Tuple position(float t);
-        Ray transform(Matrix m);
+        Ray(const Tuple &origin, const Tuple &direction);
+        const Tuple &get_origin() const;
+        const Tuple &get_direction() const;
+        Tuple position(float t) const;
+        Ray transform(const Matrix4 &m) const;
 };
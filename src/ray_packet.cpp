@@ -0,0 +1,62 @@
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "ray.h"
+#include "intersection.h"
+#include "ray_packet.h"
+
+#include <limits>
+
+
+RayPacket::RayPacket() {
+    for (unsigned int i = 0; i < size; i++) {
+        ox[i] = oy[i] = oz[i] = 0;
+        dx[i] = dy[i] = dz[i] = 0;
+    };
+    this->active = 0;
+};
+
+void RayPacket::set_ray(unsigned int lane, const Ray &r) {
+    const Tuple &origin = r.get_origin();
+    const Tuple &direction = r.get_direction();
+    ox[lane] = origin.x;
+    oy[lane] = origin.y;
+    oz[lane] = origin.z;
+    dx[lane] = direction.x;
+    dy[lane] = direction.y;
+    dz[lane] = direction.z;
+    this->active |= 1u << lane;
+};
+
+Ray RayPacket::get_ray(unsigned int lane) const {
+    return Ray(point(ox[lane], oy[lane], oz[lane]), vector(dx[lane], dy[lane], dz[lane]));
+};
+
+bool RayPacket::is_active(unsigned int lane) const {
+    return (active >> lane) & 1;
+};
+
+RayPacket RayPacket::transform(const Matrix4 &m) const {
+    const float *d = m.get_matrix_data();
+    RayPacket result;
+    for (unsigned int i = 0; i < size; i++) {
+        result.ox[i] = d[0] * ox[i] + d[1] * oy[i] + d[2]  * oz[i] + d[3];
+        result.oy[i] = d[4] * ox[i] + d[5] * oy[i] + d[6]  * oz[i] + d[7];
+        result.oz[i] = d[8] * ox[i] + d[9] * oy[i] + d[10] * oz[i] + d[11];
+        result.dx[i] = d[0] * dx[i] + d[1] * dy[i] + d[2]  * dz[i];
+        result.dy[i] = d[4] * dx[i] + d[5] * dy[i] + d[6]  * dz[i];
+        result.dz[i] = d[8] * dx[i] + d[9] * dy[i] + d[10] * dz[i];
+    };
+    result.active = active;
+    return result;
+};
+
+PacketHits::PacketHits() {
+    for (unsigned int i = 0; i < RayPacket::size; i++) {
+        t[i] = std::numeric_limits<float>::infinity();
+        object[i] = NULL;
+    };
+};
+
+Intersection PacketHits::get(unsigned int lane) const {
+    return (object[lane] == NULL) ? Intersection() : Intersection(t[lane], object[lane]);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "ray.h"
+#include "intersection.h"
+
+class Shape;
+
+// A bundle of coherent rays (neighbouring camera pixels) stored as a
+// structure of arrays, so the packet versions of the shape tests can run
+// the same arithmetic across every lane at once. Lanes whose bit is clear
+// in active hold no ray and are never updated.
+class RayPacket {
+    public:
+        static const unsigned int size = 8;
+        // Origins are points and directions vectors, so w is implied
+        alignas(32) float ox[size];
+        alignas(32) float oy[size];
+        alignas(32) float oz[size];
+        alignas(32) float dx[size];
+        alignas(32) float dy[size];
+        alignas(32) float dz[size];
+        unsigned int active;
+        // Methods
+        RayPacket();
+        void set_ray(unsigned int lane, const Ray &r);
+        Ray get_ray(unsigned int lane) const;
+        bool is_active(unsigned int lane) const;
+        // The matrix is assumed affine, as shape and camera transforms are
+        RayPacket transform(const Matrix4 &m) const;
+};
+
+// Nearest hit found so far for each lane of a packet. Shapes only replace
+// a lane's hit when they are hit closer, with 0 <= t < t[lane].
+struct PacketHits {
+    float t[RayPacket::size];
+    const Shape *object[RayPacket::size];
+    PacketHits();
+    Intersection get(unsigned int lane) const;
+};
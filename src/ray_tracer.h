@@ -1,9 +1,11 @@
 #include "canvas.h"
 #include "intersection.h"
+#include "arena.h"
 #include "intersections.h"
 #include "lights.h"
 #include "material.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "sphere.h"
 #include "transform.h"
@@ -14,3 +16,10 @@
 #include "shape.h"
 #include "plane.h"
 #include "stripe_pattern.h"
+#include "bounds.h"
+#include "bvh.h"
+#include "ray_packet.h"
+#include "scene.h"
+#include "scene_cache.h"
+#include "shape_arrays.h"
+#include "distributed_render.h"
\ No newline at end of file
@@ -0,0 +1,571 @@
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "transform.h"
+#include "material.h"
+#include "lights.h"
+#include "shape.h"
+#include "sphere.h"
+#include "plane.h"
+#include "stripe_pattern.h"
+#include "world.h"
+#include "camera.h"
+#include "scene.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+
+[[noreturn]] static void scene_error(unsigned int line, const std::string &message) {
+    throw std::invalid_argument("Scene error on line " + std::to_string(line) + ": " + message);
+};
+
+static std::string trim(const std::string &s) {
+    std::size_t start = s.find_first_not_of(' ');
+    if (start == std::string::npos) {
+        return "";
+    };
+    std::size_t end = s.find_last_not_of(' ');
+    return s.substr(start, end - start + 1);
+};
+
+// A parsed value: a plain scalar, a list or a set of key/value fields
+struct SceneNode {
+    enum Kind {SCALAR, SEQUENCE, MAPPING};
+    Kind kind = SCALAR;
+    std::string value;
+    std::vector<SceneNode> items;
+    std::vector<std::pair<std::string, SceneNode>> fields;
+    unsigned int line = 0;
+
+    const SceneNode *find(const std::string &key) const {
+        for (const std::pair<std::string, SceneNode> &field : fields) {
+            if (field.first == key) {
+                return &field.second;
+            };
+        };
+        return NULL;
+    };
+};
+
+struct SceneLine {
+    unsigned int number;
+    unsigned int indent;
+    std::string text;
+};
+
+// Hands out the lines that have content, with comments and trailing
+// spaces removed, one at a time and with one line of lookahead
+class LineReader {
+    private:
+        const std::string &text;
+        std::size_t position;
+        unsigned int number;
+        bool peeked;
+        SceneLine current;
+    public:
+        LineReader(const std::string &text) : text(text), position(0), number(0), peeked(false) {};
+        bool peek(SceneLine &line) {
+            while (!peeked && position < text.size()) {
+                std::size_t end = text.find('\n', position);
+                if (end == std::string::npos) {
+                    end = text.size();
+                };
+                std::string raw = text.substr(position, end - position);
+                position = end + 1;
+                number++;
+
+                std::size_t comment = raw.find('#');
+                if (comment != std::string::npos) {
+                    raw.erase(comment);
+                };
+                while (!raw.empty() && std::isspace((unsigned char) raw.back())) {
+                    raw.pop_back();
+                };
+                std::size_t indent = raw.find_first_not_of(' ');
+                if (indent == std::string::npos) {
+                    continue;
+                };
+                if (raw[indent] == '\t') {
+                    scene_error(number, "tabs can't be used for indentation");
+                };
+                current = SceneLine{number, (unsigned int) indent, raw.substr(indent)};
+                peeked = true;
+            };
+            if (peeked) {
+                line = current;
+            };
+            return peeked;
+        };
+        void next() {
+            peeked = false;
+        };
+};
+
+static bool is_sequence_entry(const std::string &text) {
+    return text == "-" || text.rfind("- ", 0) == 0;
+};
+
+// Splits "key: value" or "key:"; false if the text isn't a mapping entry
+static bool split_entry(const std::string &text, std::string &key, std::string &value) {
+    if (text.empty() || text[0] == '[') {
+        return false;
+    };
+    std::size_t colon = text.find(':');
+    while (colon != std::string::npos && colon + 1 < text.size() && text[colon + 1] != ' ') {
+        colon = text.find(':', colon + 1);
+    };
+    if (colon == std::string::npos || colon == 0) {
+        return false;
+    };
+    key = trim(text.substr(0, colon));
+    value = trim(text.substr(colon + 1));
+    return true;
+};
+
+// Flow values: scalars and [a, b, [c, d]] lists on a single line
+static SceneNode parse_flow(const std::string &text, std::size_t &i, unsigned int line) {
+    auto skip_spaces = [&]() {
+        while (i < text.size() && text[i] == ' ') {
+            i++;
+        };
+    };
+    skip_spaces();
+    SceneNode node;
+    node.line = line;
+    if (i < text.size() && text[i] == '[') {
+        node.kind = SceneNode::SEQUENCE;
+        i++;
+        skip_spaces();
+        if (i < text.size() && text[i] == ']') {
+            i++;
+            return node;
+        };
+        while (true) {
+            node.items.push_back(parse_flow(text, i, line));
+            skip_spaces();
+            if (i < text.size() && text[i] == ',') {
+                i++;
+            } else if (i < text.size() && text[i] == ']') {
+                i++;
+                return node;
+            } else {
+                scene_error(line, "expected ',' or ']'");
+            };
+        };
+    };
+    std::size_t start = i;
+    while (i < text.size() && text[i] != ',' && text[i] != '[' && text[i] != ']') {
+        i++;
+    };
+    node.value = trim(text.substr(start, i - start));
+    if (node.value.empty()) {
+        scene_error(line, "missing value");
+    };
+    return node;
+};
+
+static SceneNode parse_value(const std::string &text, unsigned int line) {
+    std::size_t i = 0;
+    SceneNode node = parse_flow(text, i, line);
+    if (i != text.size()) {
+        scene_error(line, "unexpected '" + text.substr(i) + "'");
+    };
+    return node;
+};
+
+// Block structure: mappings and "- " lists nested by indentation
+class BlockParser {
+    private:
+        LineReader &reader;
+        void add_entry(SceneNode &node, const std::string &key, const std::string &value, unsigned int line, unsigned int indent) {
+            if (node.find(key) != NULL) {
+                scene_error(line, "duplicate key '" + key + "'");
+            };
+            SceneNode child = value.empty() ? parse_nested(line, indent, true) : parse_value(value, line);
+            node.fields.emplace_back(key, child);
+        };
+        void parse_mapping_entries(SceneNode &node, unsigned int indent) {
+            SceneLine line;
+            while (reader.peek(line) && line.indent == indent && !is_sequence_entry(line.text)) {
+                reader.next();
+                std::string key, value;
+                if (!split_entry(line.text, key, value)) {
+                    scene_error(line.number, "expected 'key: value'");
+                };
+                add_entry(node, key, value, line.number, indent);
+            };
+            if (reader.peek(line) && line.indent >= indent) {
+                scene_error(line.number, "unexpected indentation");
+            };
+        };
+        // The block under a "key:" or "-" line. A list may also sit at the
+        // same indentation as its key.
+        SceneNode parse_nested(unsigned int line_number, unsigned int indent, bool same_indent_list) {
+            SceneLine line;
+            bool is_list = reader.peek(line) && is_sequence_entry(line.text);
+            if (!reader.peek(line) || line.indent < indent || (line.indent == indent && !(same_indent_list && is_list))) {
+                scene_error(line_number, "missing value");
+            };
+            if (is_list) {
+                return parse_sequence(line.indent);
+            };
+            SceneNode node;
+            node.kind = SceneNode::MAPPING;
+            node.line = line.number;
+            parse_mapping_entries(node, line.indent);
+            return node;
+        };
+        SceneNode parse_sequence(unsigned int indent) {
+            SceneNode node;
+            node.kind = SceneNode::SEQUENCE;
+            SceneLine line;
+            reader.peek(line);
+            node.line = line.number;
+            while (reader.peek(line) && line.indent == indent && is_sequence_entry(line.text)) {
+                node.items.push_back(parse_sequence_item(indent));
+            };
+            return node;
+        };
+    public:
+        BlockParser(LineReader &reader) : reader(reader) {};
+        // One "- " entry whose dash is at indent
+        SceneNode parse_sequence_item(unsigned int indent) {
+            SceneLine line;
+            reader.peek(line);
+            reader.next();
+            std::size_t offset = line.text.find_first_not_of(' ', 1);
+            if (offset == std::string::npos) {
+                return parse_nested(line.number, indent, false);
+            };
+            std::string rest = line.text.substr(offset);
+            std::string key, value;
+            if (!split_entry(rest, key, value)) {
+                return parse_value(rest, line.number);
+            };
+            // "- key: value" starts a mapping aligned with its first key
+            SceneNode node;
+            node.kind = SceneNode::MAPPING;
+            node.line = line.number;
+            add_entry(node, key, value, line.number, indent + offset);
+            parse_mapping_entries(node, indent + offset);
+            return node;
+        };
+};
+
+// Conversions from parsed values
+static const std::string &scalar(const SceneNode &node, const std::string &what) {
+    if (node.kind != SceneNode::SCALAR) {
+        scene_error(node.line, "expected " + what);
+    };
+    return node.value;
+};
+
+static float to_float(const SceneNode &node) {
+    const std::string &text = scalar(node, "a number");
+    char *end;
+    float value = std::strtof(text.c_str(), &end);
+    if (end == text.c_str() || *end != '\0') {
+        scene_error(node.line, "expected a number, got '" + text + "'");
+    };
+    return value;
+};
+
+static unsigned int to_size(const SceneNode &node) {
+    float value = to_float(node);
+    if (value < 1 || value != (unsigned int) value) {
+        scene_error(node.line, "expected a positive whole number");
+    };
+    return (unsigned int) value;
+};
+
+static std::vector<float> to_floats(const SceneNode &node, unsigned int count) {
+    if (node.kind != SceneNode::SEQUENCE || node.items.size() != count) {
+        scene_error(node.line, "expected a list of " + std::to_string(count) + " numbers");
+    };
+    std::vector<float> values;
+    for (const SceneNode &item : node.items) {
+        values.push_back(to_float(item));
+    };
+    return values;
+};
+
+static Tuple to_point(const SceneNode &node) {
+    std::vector<float> v = to_floats(node, 3);
+    return point(v[0], v[1], v[2]);
+};
+
+static Tuple to_vector(const SceneNode &node) {
+    std::vector<float> v = to_floats(node, 3);
+    return vector(v[0], v[1], v[2]);
+};
+
+static Color to_color(const SceneNode &node) {
+    std::vector<float> v = to_floats(node, 3);
+    return Color(v[0], v[1], v[2]);
+};
+
+static const SceneNode &required(const SceneNode &node, const std::string &key) {
+    const SceneNode *value = node.find(key);
+    if (value == NULL) {
+        scene_error(node.line, "missing '" + key + "'");
+    };
+    return *value;
+};
+
+static void check_keys(const SceneNode &node, const std::vector<std::string> &allowed) {
+    if (node.kind != SceneNode::MAPPING) {
+        scene_error(node.line, "expected 'key: value' fields");
+    };
+    for (const std::pair<std::string, SceneNode> &field : node.fields) {
+        bool known = false;
+        for (const std::string &key : allowed) {
+            known = known || field.first == key;
+        };
+        if (!known) {
+            scene_error(field.second.line, "unknown key '" + field.first + "'");
+        };
+    };
+};
+
+// Builds the scene item by item
+class SceneBuilder {
+    private:
+        std::unique_ptr<Camera> camera;
+        std::vector<PointLight> lights;
+        std::vector<std::unique_ptr<Shape>> shapes;
+        std::vector<std::unique_ptr<StripePattern>> patterns;
+        std::map<std::string, Material> materials;
+        std::map<std::string, Matrix4> transforms;
+
+        Matrix4 to_transform(const SceneNode &node) {
+            if (node.kind == SceneNode::SCALAR) {
+                return defined_transform(node);
+            };
+            if (node.kind != SceneNode::SEQUENCE) {
+                scene_error(node.line, "expected a list of transforms");
+            };
+            Matrix4 m;
+            for (const SceneNode &item : node.items) {
+                m = to_transform_step(item) * m;
+            };
+            return m;
+        };
+        Matrix4 to_transform_step(const SceneNode &node) {
+            if (node.kind == SceneNode::SCALAR) {
+                return defined_transform(node);
+            };
+            if (node.kind != SceneNode::SEQUENCE || node.items.empty()) {
+                scene_error(node.line, "expected a transform such as [translate, x, y, z]");
+            };
+            const std::string &op = scalar(node.items[0], "a transform name");
+            std::vector<float> a;
+            for (unsigned int i = 1; i < node.items.size(); i++) {
+                a.push_back(to_float(node.items[i]));
+            };
+            auto expect = [&](unsigned int count) {
+                if (a.size() != count) {
+                    scene_error(node.line, op + " takes " + std::to_string(count) + " values");
+                };
+            };
+            if (op == "translate") {
+                expect(3);
+                return translation_matrix(a[0], a[1], a[2]);
+            } else if (op == "scale") {
+                expect(3);
+                return scaling_matrix(a[0], a[1], a[2]);
+            } else if (op == "rotate-x") {
+                expect(1);
+                return rotation_x_matrix(a[0]);
+            } else if (op == "rotate-y") {
+                expect(1);
+                return rotation_y_matrix(a[0]);
+            } else if (op == "rotate-z") {
+                expect(1);
+                return rotation_z_matrix(a[0]);
+            } else if (op == "shear") {
+                expect(6);
+                return shearing_matrix(a[0], a[1], a[2], a[3], a[4], a[5]);
+            };
+            scene_error(node.line, "unknown transform '" + op + "'");
+        };
+        Matrix4 defined_transform(const SceneNode &node) {
+            const std::string &name = scalar(node, "a transform");
+            std::map<std::string, Matrix4>::iterator found = transforms.find(name);
+            if (found == transforms.end()) {
+                scene_error(node.line, "no transform named '" + name + "'");
+            };
+            return found->second;
+        };
+
+        Material to_material(const SceneNode &node, Material m) {
+            if (node.kind == SceneNode::SCALAR) {
+                const std::string &name = node.value;
+                std::map<std::string, Material>::iterator found = materials.find(name);
+                if (found == materials.end()) {
+                    scene_error(node.line, "no material named '" + name + "'");
+                };
+                return found->second;
+            };
+            check_keys(node, {"color", "ambient", "diffuse", "specular", "shininess", "pattern"});
+            for (const std::pair<std::string, SceneNode> &field : node.fields) {
+                const std::string &key = field.first;
+                const SceneNode &value = field.second;
+                if (key == "color") {
+                    m.color = to_color(value);
+                } else if (key == "ambient") {
+                    m.ambient = to_float(value);
+                } else if (key == "diffuse") {
+                    m.diffuse = to_float(value);
+                } else if (key == "specular") {
+                    m.specular = to_float(value);
+                } else if (key == "shininess") {
+                    m.shininess = to_float(value);
+                } else if (key == "pattern") {
+                    m.pattern = to_pattern(value);
+                };
+            };
+            return m;
+        };
+        StripePattern * to_pattern(const SceneNode &node) {
+            check_keys(node, {"type", "colors", "transform"});
+            const SceneNode &type = required(node, "type");
+            if (scalar(type, "a pattern type") != "stripes") {
+                scene_error(type.line, "unknown pattern '" + type.value + "'");
+            };
+            const SceneNode &colors = required(node, "colors");
+            if (colors.kind != SceneNode::SEQUENCE || colors.items.size() != 2) {
+                scene_error(colors.line, "stripes take a list of two colors");
+            };
+            Matrix4 t;
+            if (const SceneNode *transform = node.find("transform")) {
+                t = to_transform(*transform);
+            };
+            patterns.emplace_back(new StripePattern(to_color(colors.items[0]), to_color(colors.items[1]), t));
+            return patterns.back().get();
+        };
+
+        void add_camera(const SceneNode &item) {
+            check_keys(item, {"add", "width", "height", "field-of-view", "from", "to", "up"});
+            if (camera) {
+                scene_error(item.line, "the scene already has a camera");
+            };
+            camera.reset(new Camera(
+                to_size(required(item, "width")),
+                to_size(required(item, "height")),
+                to_float(required(item, "field-of-view"))
+            ));
+            const SceneNode *up = item.find("up");
+            (*camera).set_transform(view_transform(
+                to_point(required(item, "from")),
+                to_point(required(item, "to")),
+                (up != NULL) ? to_vector(*up) : vector(0, 1, 0)
+            ));
+        };
+        void add_light(const SceneNode &item) {
+            check_keys(item, {"add", "at", "intensity"});
+            lights.push_back(PointLight(
+                to_point(required(item, "at")),
+                to_color(required(item, "intensity"))
+            ));
+        };
+        void add_shape(const SceneNode &item, Shape * shape) {
+            shapes.emplace_back(shape);
+            check_keys(item, {"add", "material", "transform"});
+            if (const SceneNode *material = item.find("material")) {
+                (*shape).set_material(to_material(*material, Material()));
+            };
+            if (const SceneNode *transform = item.find("transform")) {
+                (*shape).set_transform(to_transform(*transform));
+            };
+        };
+        // A mapping value defines a material, a list a transform
+        void add_define(const SceneNode &item) {
+            check_keys(item, {"define", "extend", "value"});
+            const std::string &name = scalar(required(item, "define"), "a name");
+            const SceneNode &value = required(item, "value");
+            const SceneNode *extend = item.find("extend");
+            if (value.kind == SceneNode::MAPPING) {
+                Material base = (extend != NULL) ? to_material(*extend, Material()) : Material();
+                materials[name] = to_material(value, base);
+            } else {
+                Matrix4 base = (extend != NULL) ? defined_transform(*extend) : Matrix4();
+                transforms[name] = to_transform(value) * base;
+            };
+        };
+    public:
+        void add(const SceneNode &item) {
+            if (item.kind != SceneNode::MAPPING) {
+                scene_error(item.line, "expected an 'add' or 'define' item");
+            };
+            if (const SceneNode *type = item.find("add")) {
+                const std::string &name = scalar(*type, "an item type");
+                if (name == "camera") {
+                    add_camera(item);
+                } else if (name == "light") {
+                    add_light(item);
+                } else if (name == "sphere") {
+                    add_shape(item, new Sphere());
+                } else if (name == "plane") {
+                    add_shape(item, new Plane());
+                } else {
+                    scene_error(type->line, "unknown item '" + name + "'");
+                };
+            } else if (item.find("define") != NULL) {
+                add_define(item);
+            } else {
+                scene_error(item.line, "expected an 'add' or 'define' item");
+            };
+        };
+        Scene finish() {
+            if (!camera) {
+                throw std::invalid_argument("Scene error: the scene has no camera.");
+            };
+            if (lights.empty()) {
+                throw std::invalid_argument("Scene error: the scene has no lights.");
+            };
+            Scene scene(*camera);
+            std::vector<Shape *> objects;
+            for (std::unique_ptr<Shape> &shape : shapes) {
+                objects.push_back(shape.get());
+            };
+            scene.world = World(objects, lights);
+            scene.shapes = std::move(shapes);
+            scene.patterns = std::move(patterns);
+            return scene;
+        };
+};
+
+Scene parse_scene(const std::string &text) {
+    LineReader reader(text);
+    BlockParser parser(reader);
+    SceneBuilder builder;
+    SceneLine line;
+    if (!reader.peek(line)) {
+        return builder.finish();
+    };
+    unsigned int indent = line.indent;
+    while (reader.peek(line)) {
+        if (line.indent != indent || !is_sequence_entry(line.text)) {
+            scene_error(line.number, "expected a '- ' list item");
+        };
+        builder.add(parser.parse_sequence_item(indent));
+    };
+    return builder.finish();
+};
+
+Scene load_scene(const std::string &filename) {
+    std::ifstream file(filename);
+    if (!file) {
+        throw std::runtime_error("Could not open scene file " + filename);
+    };
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return parse_scene(contents.str());
+};
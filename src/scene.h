@@ -0,0 +1,61 @@
+#pragma once
+
+#include "tuple.h"
+#include "shape.h"
+#include "stripe_pattern.h"
+#include "world.h"
+#include "camera.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+
+// Scene files
+// A subset of YAML in the style of the book's bonus scene files. The file
+// is a list of items, each either adding something to the scene or
+// defining a named material or transform for later items to reuse:
+//
+//   - add: camera
+//     width: 640
+//     height: 360
+//     field-of-view: 1.047
+//     from: [0, 1.5, -5]
+//     to: [0, 1, 0]
+//     up: [0, 1, 0]
+//   - add: light
+//     at: [-10, 10, -10]
+//     intensity: [1, 1, 1]
+//   - define: shiny
+//     value:
+//       specular: 0.9
+//       shininess: 300
+//   - add: sphere
+//     material: shiny
+//     transform:
+//       - [scale, 0.5, 0.5, 0.5]
+//       - [translate, 1, 0.5, 0]
+//
+// Shapes are sphere and plane. Material keys are color, ambient, diffuse,
+// specular, shininess and pattern; a pattern has type: stripes, colors
+// (a list of two colours) and an optional transform. Transform steps are
+// translate, scale, rotate-x/y/z, shear or the name of a defined
+// transform, applied in the order listed. A define may extend an earlier
+// one, overriding its keys. Unknown keys are errors.
+//
+// Each item is built as soon as it has been read, so the text is parsed
+// in a single pass.
+class Scene {
+    public:
+        Camera camera;
+        World world;
+        // The world's shapes and the materials' patterns are owned here
+        std::vector<std::unique_ptr<Shape>> shapes;
+        std::vector<std::unique_ptr<StripePattern>> patterns;
+        Scene(const Camera &camera) : camera(camera) {};
+};
+
+// Throws std::invalid_argument, naming the line, for malformed scenes
+Scene parse_scene(const std::string &text);
+// Throws std::runtime_error if the file can't be read
+Scene load_scene(const std::string &filename);
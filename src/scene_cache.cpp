@@ -0,0 +1,426 @@
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "material.h"
+#include "lights.h"
+#include "shape.h"
+#include "sphere.h"
+#include "plane.h"
+#include "stripe_pattern.h"
+#include "bvh.h"
+#include "world.h"
+#include "camera.h"
+#include "scene.h"
+#include "scene_cache.h"
+
+#include <array>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+// On-disk records. Every field is 4 bytes wide, so the records are packed
+// without padding and can be read straight from the mapped file, without
+// parsing, before being copied into the scene's objects.
+static const char cache_magic[8] = {'R', 'T', 'C', 'S', 'C', 'E', 'N', 'E'};
+
+// Stored frame sizes outside these bounds are taken as corruption rather
+// than handed to Camera, whose canvas size has to fit an unsigned int
+static const uint32_t max_frame_side = 1 << 16;
+static const uint64_t max_frame_pixels = 1 << 28;
+
+struct CameraRecord {
+    uint32_t hsize;
+    uint32_t vsize;
+    float field_of_view;
+    float transform[16];
+};
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t pattern_count;
+    uint32_t shape_count;
+    uint32_t light_count;
+    uint32_t node_count;
+    // Shapes in BVH leaf order, then the unbounded ones
+    uint32_t bvh_shape_count;
+    uint32_t unbounded_count;
+    float light_cutoff;
+    CameraRecord camera;
+};
+
+struct PatternRecord {
+    float a[3];
+    float b[3];
+    float transform[16];
+    float inverse[16];
+};
+
+enum ShapeType : uint32_t {
+    SPHERE = 0,
+    PLANE = 1
+};
+
+struct ShapeRecord {
+    uint32_t type;
+    // Index into the pattern records, or -1 for none
+    int32_t pattern;
+    float transform[16];
+    float inverse[16];
+    float color[3];
+    float ambient;
+    float diffuse;
+    float specular;
+    float shininess;
+};
+
+struct LightRecord {
+    float position[3];
+    float intensity[3];
+};
+
+struct NodeRecord {
+    float min[3];
+    float max[3];
+    uint32_t offset;
+    uint32_t count;
+    uint32_t axis;
+};
+
+static_assert(sizeof(CacheHeader) == 8 + 8 * 4 + 19 * 4, "CacheHeader must not be padded");
+static_assert(sizeof(ShapeRecord) == 41 * 4, "ShapeRecord must not be padded");
+static_assert(sizeof(NodeRecord) == 9 * 4, "NodeRecord must not be padded");
+
+static void store_matrix(const Matrix4 &m, float *out) {
+    std::memcpy(out, m.get_matrix_data(), 16 * sizeof(float));
+};
+
+static Matrix4 load_matrix(const float *data) {
+    std::array<float, 16> values;
+    std::memcpy(values.data(), data, 16 * sizeof(float));
+    return Matrix4(values);
+};
+
+static void store_color(const Color &c, float *out) {
+    out[0] = c.red;
+    out[1] = c.green;
+    out[2] = c.blue;
+};
+
+static void store_point(const Tuple &t, float *out) {
+    out[0] = t.x;
+    out[1] = t.y;
+    out[2] = t.z;
+};
+
+template <typename T>
+static void append(std::vector<uint8_t> &out, const T &record) {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&record);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+};
+
+void write_scene_cache(const World &world, const Camera &camera, const std::string &filename) {
+    // The stored BVH must match the object list
+    World with_bvh;
+    if (!world.has_bvh()) {
+        with_bvh = world;
+        with_bvh.build_bvh();
+    };
+    const World &w = world.has_bvh() ? world : with_bvh;
+
+    std::map<const Shape *, uint32_t> shape_index;
+    std::map<const StripePattern *, int32_t> pattern_index;
+    std::vector<const StripePattern *> patterns;
+    for (const Shape * s : w.objects) {
+        uint32_t index = shape_index.size();
+        shape_index[s] = index;
+        const StripePattern * p = (*s).get_material().pattern;
+        if (p != NULL && pattern_index.find(p) == pattern_index.end()) {
+            pattern_index[p] = patterns.size();
+            patterns.push_back(p);
+        };
+    };
+
+    const std::vector<BVHNode> &nodes = w.bvh.get_nodes();
+    const std::vector<Shape *> &bvh_shapes = w.bvh.get_shapes();
+    const std::vector<Shape *> &unbounded = w.bvh.get_unbounded();
+
+    CacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = scene_cache_version;
+    header.pattern_count = patterns.size();
+    header.shape_count = w.objects.size();
+    header.light_count = w.lights.size();
+    header.node_count = nodes.size();
+    header.bvh_shape_count = bvh_shapes.size();
+    header.unbounded_count = unbounded.size();
+    header.light_cutoff = w.light_cutoff;
+    header.camera.hsize = camera.hsize;
+    header.camera.vsize = camera.vsize;
+    header.camera.field_of_view = camera.field_of_view;
+    store_matrix(camera.get_transform(), header.camera.transform);
+
+    std::vector<uint8_t> out;
+    append(out, header);
+    for (const StripePattern * p : patterns) {
+        PatternRecord record;
+        store_color((*p).get_a(), record.a);
+        store_color((*p).get_b(), record.b);
+        store_matrix((*p).get_transform(), record.transform);
+        store_matrix((*p).get_inverse_transform(), record.inverse);
+        append(out, record);
+    };
+    for (const Shape * s : w.objects) {
+        ShapeRecord record;
+        if (dynamic_cast<const Sphere *>(s) != NULL) {
+            record.type = SPHERE;
+        } else if (dynamic_cast<const Plane *>(s) != NULL) {
+            record.type = PLANE;
+        } else {
+            throw std::invalid_argument("Only spheres and planes can be stored in a scene cache.");
+        };
+        const Material &m = (*s).get_material();
+        record.pattern = (m.pattern != NULL) ? pattern_index[m.pattern] : -1;
+        store_matrix((*s).get_transform(), record.transform);
+        store_matrix((*s).get_inverse_transform(), record.inverse);
+        store_color(m.color, record.color);
+        record.ambient = m.ambient;
+        record.diffuse = m.diffuse;
+        record.specular = m.specular;
+        record.shininess = m.shininess;
+        append(out, record);
+    };
+    for (const PointLight &l : w.lights) {
+        LightRecord record;
+        store_point(l.get_position(), record.position);
+        store_color(l.get_intensity(), record.intensity);
+        append(out, record);
+    };
+    for (const BVHNode &node : nodes) {
+        NodeRecord record;
+        store_point(node.box.min, record.min);
+        store_point(node.box.max, record.max);
+        record.offset = node.offset;
+        record.count = node.count;
+        record.axis = node.axis;
+        append(out, record);
+    };
+    for (const Shape * s : bvh_shapes) {
+        append(out, shape_index[s]);
+    };
+    for (const Shape * s : unbounded) {
+        append(out, shape_index[s]);
+    };
+
+    FILE * file = std::fopen(filename.c_str(), "wb");
+    if (file == NULL) {
+        throw std::runtime_error("Could not open " + filename + " for writing.");
+    };
+    bool written = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+    written = (std::fclose(file) == 0) && written;
+    if (!written) {
+        throw std::runtime_error("Could not write " + filename + ".");
+    };
+};
+
+// Read-only mapping of a whole file, unmapped when it goes out of scope
+class MappedFile {
+    private:
+        void * data;
+        std::size_t length;
+    public:
+        MappedFile(const std::string &filename) : data(MAP_FAILED), length(0) {
+            int fd = open(filename.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Could not open scene cache " + filename);
+            };
+            struct stat info;
+            if (fstat(fd, &info) == 0 && info.st_size > 0) {
+                length = info.st_size;
+                data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            };
+            close(fd);
+            if (data == MAP_FAILED) {
+                throw std::runtime_error("Could not map scene cache " + filename);
+            };
+        };
+        ~MappedFile() {
+            munmap(data, length);
+        };
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        const uint8_t * bytes() const {
+            return static_cast<const uint8_t *>(data);
+        };
+        std::size_t size() const {
+            return length;
+        };
+};
+
+// Hands out consecutive records from the mapped file, checking each fits
+class RecordReader {
+    private:
+        const MappedFile &file;
+        std::size_t position;
+        const std::string &filename;
+    public:
+        RecordReader(const MappedFile &file, const std::string &filename) : file(file), position(0), filename(filename) {};
+        template <typename T>
+        const T * take(std::size_t count) {
+            if ((file.size() - position) / sizeof(T) < count) {
+                throw std::runtime_error("Scene cache " + filename + " is truncated.");
+            };
+            const T * records = reinterpret_cast<const T *>(file.bytes() + position);
+            position += count * sizeof(T);
+            return records;
+        };
+        bool at_end() const {
+            return position == file.size();
+        };
+};
+
+Scene load_scene_cache(const std::string &filename) {
+    MappedFile file(filename);
+    RecordReader reader(file, filename);
+    const CacheHeader &header = *reader.take<CacheHeader>(1);
+    if (std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0) {
+        throw std::runtime_error(filename + " is not a scene cache.");
+    };
+    if (header.version != scene_cache_version) {
+        throw std::runtime_error(
+            "Scene cache " + filename + " has version " + std::to_string(header.version)
+            + ", expected " + std::to_string(scene_cache_version) + "."
+        );
+    };
+    const PatternRecord * pattern_records = reader.take<PatternRecord>(header.pattern_count);
+    const ShapeRecord * shape_records = reader.take<ShapeRecord>(header.shape_count);
+    const LightRecord * light_records = reader.take<LightRecord>(header.light_count);
+    const NodeRecord * node_records = reader.take<NodeRecord>(header.node_count);
+    const uint32_t * bvh_indices = reader.take<uint32_t>(header.bvh_shape_count);
+    const uint32_t * unbounded_indices = reader.take<uint32_t>(header.unbounded_count);
+    if (!reader.at_end()) {
+        throw std::runtime_error("Scene cache " + filename + " has trailing data.");
+    };
+    auto corrupt = [&]() {
+        return std::runtime_error("Scene cache " + filename + " is corrupt.");
+    };
+
+    uint32_t hsize = header.camera.hsize;
+    uint32_t vsize = header.camera.vsize;
+    if (hsize == 0 || vsize == 0 || hsize > max_frame_side || vsize > max_frame_side
+        || (uint64_t) hsize * vsize > max_frame_pixels) {
+        throw corrupt();
+    };
+    Camera camera(hsize, vsize, header.camera.field_of_view);
+    camera.set_transform(load_matrix(header.camera.transform));
+    Scene scene(camera);
+
+    for (uint32_t i = 0; i < header.pattern_count; i++) {
+        const PatternRecord &r = pattern_records[i];
+        StripePattern * p = new StripePattern(Color(r.a[0], r.a[1], r.a[2]), Color(r.b[0], r.b[1], r.b[2]));
+        scene.patterns.emplace_back(p);
+        (*p).set_transform(load_matrix(r.transform), load_matrix(r.inverse));
+    };
+
+    std::vector<Shape *> objects;
+    for (uint32_t i = 0; i < header.shape_count; i++) {
+        const ShapeRecord &r = shape_records[i];
+        Shape * s;
+        if (r.type == SPHERE) {
+            s = new Sphere();
+        } else if (r.type == PLANE) {
+            s = new Plane();
+        } else {
+            throw corrupt();
+        };
+        scene.shapes.emplace_back(s);
+        if (r.pattern >= (int32_t) header.pattern_count) {
+            throw corrupt();
+        };
+        (*s).set_transform(load_matrix(r.transform), load_matrix(r.inverse));
+        (*s).set_material(Material(
+            (r.pattern >= 0) ? scene.patterns[r.pattern].get() : NULL,
+            Color(r.color[0], r.color[1], r.color[2]),
+            r.ambient,
+            r.diffuse,
+            r.specular,
+            r.shininess
+        ));
+        objects.push_back(s);
+    };
+
+    std::vector<PointLight> lights;
+    for (uint32_t i = 0; i < header.light_count; i++) {
+        const LightRecord &r = light_records[i];
+        lights.push_back(PointLight(
+            point(r.position[0], r.position[1], r.position[2]),
+            Color(r.intensity[0], r.intensity[1], r.intensity[2])
+        ));
+    };
+    scene.world = World(objects, lights);
+    scene.world.light_cutoff = header.light_cutoff;
+
+    std::vector<BVHNode> nodes;
+    for (uint32_t i = 0; i < header.node_count; i++) {
+        const NodeRecord &r = node_records[i];
+        nodes.push_back(BVHNode{
+            BoundingBox(point(r.min[0], r.min[1], r.min[2]), point(r.max[0], r.max[1], r.max[2])),
+            r.offset,
+            r.count,
+            r.axis
+        });
+    };
+    // Between them the BVH's shapes and the unbounded ones must list every
+    // object exactly once
+    if ((uint64_t) header.bvh_shape_count + header.unbounded_count != objects.size()) {
+        throw corrupt();
+    };
+    std::vector<bool> listed(objects.size(), false);
+    auto shapes_at = [&](const uint32_t * indices, uint32_t count) {
+        std::vector<Shape *> list;
+        for (uint32_t i = 0; i < count; i++) {
+            if (indices[i] >= objects.size() || listed[indices[i]]) {
+                throw corrupt();
+            };
+            listed[indices[i]] = true;
+            list.push_back(objects[indices[i]]);
+        };
+        return list;
+    };
+    if (!objects.empty()) {
+        // restore checks that the nodes form a tree the traversal can handle
+        try {
+            scene.world.bvh.restore(
+                nodes,
+                shapes_at(bvh_indices, header.bvh_shape_count),
+                shapes_at(unbounded_indices, header.unbounded_count)
+            );
+        } catch (const std::invalid_argument &) {
+            throw corrupt();
+        };
+    };
+    return scene;
+};
+
+bool is_scene_cache(const std::string &filename) {
+    char magic[sizeof(cache_magic)];
+    FILE * file = std::fopen(filename.c_str(), "rb");
+    if (file == NULL) {
+        return false;
+    };
+    bool match = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+        && std::memcmp(magic, cache_magic, sizeof(magic)) == 0;
+    std::fclose(file);
+    return match;
+};
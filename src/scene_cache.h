@@ -0,0 +1,36 @@
+#pragma once
+
+#include "world.h"
+#include "camera.h"
+#include "scene.h"
+
+#include <string>
+
+
+// Compiled scene cache
+// A binary snapshot of a world and camera that loads without parsing text
+// or inverting matrices: shapes and patterns are stored with their
+// inverse transforms, and the world's BVH is stored flattened so it
+// doesn't need rebuilding. The file is memory-mapped when loaded and its
+// fixed-size records are read from the mapping, then copied into newly
+// allocated shapes and patterns owned by the returned Scene; the mapping
+// is released before returning.
+//
+// Layout, in native byte order: a header with a magic string, the format
+// version, the record counts, the world's light cutoff and the camera,
+// followed by the pattern, shape, light and BVH node records and the BVH's
+// shape order. Bump
+// scene_cache_version whenever the layout changes; older files are then
+// rejected rather than misread.
+const unsigned int scene_cache_version = 2;
+
+// Only spheres and planes can be stored; anything else throws
+// std::invalid_argument. Throws std::runtime_error if the file can't be
+// written.
+void write_scene_cache(const World &world, const Camera &camera, const std::string &filename);
+// Throws std::runtime_error if the file can't be read, isn't a scene cache,
+// was written with a different version or is corrupt, e.g. with an empty
+// frame or a BVH that doesn't hold every shape exactly once
+Scene load_scene_cache(const std::string &filename);
+// True if the file starts with the scene cache magic string
+bool is_scene_cache(const std::string &filename);
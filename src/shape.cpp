@@ -1,8 +1,11 @@
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "material.h"
 #include "intersections.h"
+#include "bounds.h"
+#include "ray_packet.h"
 
 #include "shape.h"
 
@@ -12,42 +15,118 @@
 
 
 // Chapter 9: Shapes and Planes
-Shape::Shape(Matrix t, Material m) {
-    this->transformation = t;
+Shape::Shape(const Matrix4 &t, const Material &m) {
+    set_transform(t);
     this->material = m;
 };
 
-Matrix Shape::get_transform() {
+const Matrix4 &Shape::get_transform() const {
     return transformation;
 };
 
-void Shape::set_transform(Matrix m) {
+void Shape::set_transform(const Matrix4 &m) {
     this->transformation = m;
+    this->inverse_transformation = m.inverse();
+    this->inverse_transpose = this->inverse_transformation.transpose();
 };
 
-Material Shape::get_material() {
+void Shape::set_transform(const Matrix4 &m, const Matrix4 &inverse) {
+    this->transformation = m;
+    this->inverse_transformation = inverse;
+    this->inverse_transpose = inverse.transpose();
+};
+
+const Matrix4 &Shape::get_inverse_transform() const {
+    return inverse_transformation;
+};
+
+const Matrix4 &Shape::get_inverse_transpose() const {
+    return inverse_transpose;
+};
+
+const Material &Shape::get_material() const {
     return material;
 };
 
-void Shape::set_material(Material m) {
+void Shape::set_material(const Material &m) {
     this->material = m;
 };
 
-Intersections Shape::intersect(Ray r) {
-    Ray local_ray = r.transform(get_transform().inverse());
+Intersections Shape::intersect(const Ray &r) const {
+    Ray local_ray = r.transform(inverse_transformation);
     return local_intersect(local_ray);
 };
 
+void Shape::intersect_into(const Ray &r, Intersections &xs) const {
+    Ray local_ray = r.transform(inverse_transformation);
+    local_intersect_into(local_ray, xs);
+};
+
+void Shape::local_intersect_into(const Ray &r, Intersections &xs) const {
+    xs.append(local_intersect(r));
+};
+
+bool Shape::nearest_hit(const Ray &r, float t_max, float &t) const {
+    Ray local_ray = r.transform(inverse_transformation);
+    return local_nearest_hit(local_ray, t_max, t);
+};
+
+// Shapes without an allocation-free test fall back to the full intersection list
+bool Shape::local_nearest_hit(const Ray &r, float t_max, float &t) const {
+    Intersections xs = local_intersect(r);
+    bool found = false;
+    for (int i=0; i<xs.count; i++) {
+        if (xs[i].t >= 0 && xs[i].t < t_max) {
+            t_max = xs[i].t;
+            found = true;
+        };
+    };
+    if (found) {
+        t = t_max;
+    };
+    return found;
+};
+
+void Shape::nearest_hits(const RayPacket &r, PacketHits &hits) const {
+    RayPacket local_packet = r.transform(inverse_transformation);
+    local_nearest_hits(local_packet, hits);
+};
+
+// Shapes without a packet test answer each lane with the single ray query
+void Shape::local_nearest_hits(const RayPacket &r, PacketHits &hits) const {
+    float t;
+    for (unsigned int i = 0; i < RayPacket::size; i++) {
+        if (r.is_active(i) && local_nearest_hit(r.get_ray(i), hits.t[i], t)) {
+            hits.t[i] = t;
+            hits.object[i] = this;
+        };
+    };
+};
+
+bool Shape::occludes(const Ray &r, float distance) const {
+    float t;
+    return nearest_hit(r, distance, t);
+};
+
 // page 120 of RTC
-Tuple Shape::normal_at(Tuple p) {
-    Tuple local_point = get_transform().inverse() * p;
+Tuple Shape::normal_at(const Tuple &p) const {
+    Tuple local_point = inverse_transformation * p;
     Tuple local_normal = local_normal_at(local_point);
-    Tuple world_normal = get_transform().inverse().transpose() * local_normal;
+    Tuple world_normal = inverse_transpose * local_normal;
     world_normal.w = 0;
 
     return world_normal.normalize();
 };
 
-Tuple Shape::normal_at(float x, float y, float z) {
+Tuple Shape::normal_at(float x, float y, float z) const {
     return normal_at(point(x, y, z));
 };
+
+BoundingBox Shape::local_bounds() const {
+    return BoundingBox::infinite();
+};
+
+// World-space bounds
+BoundingBox Shape::bounds() const {
+    return local_bounds().transform(transformation);
+};
@@ -2,9 +2,12 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "material.h"
 #include "intersections.h"
+#include "bounds.h"
+#include "ray_packet.h"
 
 #include <vector>
 #include <random> 
@@ -13,20 +16,42 @@
 // Chapter 9: Shapes and Planes
 class Shape {
     protected:
-        Matrix transformation;
+        Matrix4 transformation;
+        // Cached when the transform is set so rays don't re-invert it
+        Matrix4 inverse_transformation;
+        Matrix4 inverse_transpose;
         Material material;
     public:
         // Methods
-        Shape(Matrix t = identity_matrix(4), Material m = Material());
-        Shape(Matrix t) : Shape(t, Material()) {};
-        Shape(Material m) : Shape(identity_matrix(4), m) {};
-        Matrix get_transform();
-        void set_transform(Matrix);
-        Material get_material();
-        void set_material(Material);
-        Intersections intersect(Ray r);
-        virtual Intersections local_intersect(Ray r) = 0;
-        Tuple normal_at(Tuple p);
-        Tuple normal_at(float x, float y, float z);
-        virtual Tuple local_normal_at(Tuple p) = 0;
+        Shape(const Matrix4 &t = Matrix4(), const Material &m = Material());
+        Shape(const Matrix4 &t) : Shape(t, Material()) {};
+        Shape(const Material &m) : Shape(Matrix4(), m) {};
+        const Matrix4 &get_transform() const;
+        void set_transform(const Matrix4 &);
+        // For transforms whose inverse is already known, e.g. from a scene cache
+        void set_transform(const Matrix4 &m, const Matrix4 &inverse);
+        const Matrix4 &get_inverse_transform() const;
+        const Matrix4 &get_inverse_transpose() const;
+        const Material &get_material() const;
+        void set_material(const Material &);
+        Intersections intersect(const Ray &r) const;
+        virtual Intersections local_intersect(const Ray &r) const = 0;
+        // Appends the intersections to xs instead of returning a new list
+        void intersect_into(const Ray &r, Intersections &xs) const;
+        virtual void local_intersect_into(const Ray &r, Intersections &xs) const;
+        // Nearest intersection with 0 <= t < t_max, written to t if found
+        bool nearest_hit(const Ray &r, float t_max, float &t) const;
+        virtual bool local_nearest_hit(const Ray &r, float t_max, float &t) const;
+        // Packet form of nearest_hit for every active lane, bounded by and
+        // written to hits
+        void nearest_hits(const RayPacket &r, PacketHits &hits) const;
+        virtual void local_nearest_hits(const RayPacket &r, PacketHits &hits) const;
+        // Any-hit query: is there an intersection with 0 <= t < distance?
+        bool occludes(const Ray &r, float distance) const;
+        Tuple normal_at(const Tuple &p) const;
+        Tuple normal_at(float x, float y, float z) const;
+        virtual Tuple local_normal_at(const Tuple &p) const = 0;
+        // Object-space bounds; unbounded unless a shape overrides it
+        virtual BoundingBox local_bounds() const;
+        BoundingBox bounds() const;
 };
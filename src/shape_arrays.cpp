@@ -0,0 +1,121 @@
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "ray.h"
+#include "intersection.h"
+#include "shape.h"
+#include "sphere.h"
+#include "plane.h"
+#include "shape_arrays.h"
+
+#include <vector>
+#include <limits>
+
+
+ShapeArrays::ShapeArrays() {
+    this->shape_count = 0;
+};
+
+void ShapeArrays::add(Group &group, const Shape * s) {
+    group.inverse.push_back((*s).get_inverse_transform());
+    group.shapes.push_back(s);
+};
+
+void ShapeArrays::build(const std::vector<Shape *> &objects) {
+    spheres = Group();
+    planes = Group();
+    others.clear();
+    shape_count = objects.size();
+    for (const Shape * s : objects) {
+        if (dynamic_cast<const Sphere *>(s) != NULL) {
+            add(spheres, s);
+        } else if (dynamic_cast<const Plane *>(s) != NULL) {
+            add(planes, s);
+        } else {
+            others.push_back(s);
+        };
+    };
+};
+
+bool ShapeArrays::is_built() const {
+    return shape_count > 0;
+};
+
+unsigned int ShapeArrays::get_shape_count() const {
+    return shape_count;
+};
+
+unsigned int ShapeArrays::get_sphere_count() const {
+    return spheres.shapes.size();
+};
+
+unsigned int ShapeArrays::get_plane_count() const {
+    return planes.shapes.size();
+};
+
+// The object-space test of one shape type, e.g. Sphere::unit_sphere_hit.
+// Passed as a template argument so each group's loop calls it directly.
+typedef bool (*HitTest)(const Tuple &origin, const Tuple &direction, float t_max, float &t);
+
+// Runs the test for each shape of the group in its object space, keeping
+// the nearest hit
+template <HitTest hit>
+static void closest_in_group(
+    const std::vector<Matrix4> &inverse,
+    const std::vector<const Shape *> &shapes,
+    const Ray &r,
+    float &t_max,
+    const Shape * &closest
+) {
+    float t;
+    for (unsigned int i = 0; i < inverse.size(); i++) {
+        Tuple origin = inverse[i] * r.get_origin();
+        Tuple direction = inverse[i] * r.get_direction();
+        if (hit(origin, direction, t_max, t)) {
+            t_max = t;
+            closest = shapes[i];
+        };
+    };
+};
+
+template <HitTest hit>
+static bool any_in_group(const std::vector<Matrix4> &inverse, const Ray &r, float t_max) {
+    float t;
+    for (unsigned int i = 0; i < inverse.size(); i++) {
+        Tuple origin = inverse[i] * r.get_origin();
+        Tuple direction = inverse[i] * r.get_direction();
+        if (hit(origin, direction, t_max, t)) {
+            return true;
+        };
+    };
+    return false;
+};
+
+Intersection ShapeArrays::closest_hit(const Ray &r) const {
+    float t_max = std::numeric_limits<float>::infinity();
+    const Shape * closest = NULL;
+    closest_in_group<Sphere::unit_sphere_hit>(spheres.inverse, spheres.shapes, r, t_max, closest);
+    closest_in_group<Plane::xz_plane_hit>(planes.inverse, planes.shapes, r, t_max, closest);
+    float t;
+    for (const Shape * s : others) {
+        if ((*s).nearest_hit(r, t_max, t)) {
+            t_max = t;
+            closest = s;
+        };
+    };
+    return (closest == NULL) ? Intersection() : Intersection(t_max, closest);
+};
+
+bool ShapeArrays::occluded(const Ray &r, float t_max) const {
+    if (any_in_group<Sphere::unit_sphere_hit>(spheres.inverse, r, t_max)) {
+        return true;
+    };
+    if (any_in_group<Plane::xz_plane_hit>(planes.inverse, r, t_max)) {
+        return true;
+    };
+    for (const Shape * s : others) {
+        if ((*s).occludes(r, t_max)) {
+            return true;
+        };
+    };
+    return false;
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "tuple.h"
+#include "fixed_matrix.h"
+#include "ray.h"
+#include "intersection.h"
+
+#include <vector>
+
+class Shape;
+
+// The shapes of a World grouped by type, with what the intersection tests
+// need (each shape's inverse transform) stored contiguously per type.
+// Queries loop over each group calling the type's own test directly, so
+// there are no virtual calls and no pointer chasing in the inner loop.
+// Shapes of any other type are kept in a separate list and tested through
+// Shape as usual. Hits still report the original Shape. build() copies the
+// inverse transforms, so rebuild after changing a shape's transform.
+class ShapeArrays {
+    private:
+        struct Group {
+            std::vector<Matrix4> inverse;
+            std::vector<const Shape *> shapes;
+        };
+        Group spheres;
+        Group planes;
+        std::vector<const Shape *> others;
+        unsigned int shape_count;
+        void add(Group &group, const Shape * s);
+    public:
+        ShapeArrays();
+        void build(const std::vector<Shape *> &objects);
+        bool is_built() const;
+        unsigned int get_shape_count() const;
+        unsigned int get_sphere_count() const;
+        unsigned int get_plane_count() const;
+        // Nearest hit with 0 <= t, or an empty Intersection
+        Intersection closest_hit(const Ray &r) const;
+        // True as soon as any shape is hit with 0 <= t < t_max
+        bool occluded(const Ray &r, float t_max) const;
+};
@@ -1,15 +1,18 @@
 #include "sphere.h"
 
+#include <cmath>
+#include <algorithm>
 
-Tuple Sphere::get_center() {
+
+const Tuple &Sphere::get_center() const {
     return center;
 };
 
-float Sphere::get_radius() {
+float Sphere::get_radius() const {
     return radius;
 };
 
-bool operator==(Sphere lhs, Sphere rhs) {
+bool operator==(const Sphere &lhs, const Sphere &rhs) {
     return (
         lhs.get_center() == rhs.get_center() &&
         equalByEpsilon(lhs.get_radius(), rhs.get_radius()) &&
@@ -18,27 +21,33 @@ bool operator==(Sphere lhs, Sphere rhs) {
     );
 };
 
-bool operator!=(Sphere lhs, Sphere rhs) {
+bool operator!=(const Sphere &lhs, const Sphere &rhs) {
     return !(lhs == rhs);
 };
 
 // chapter 6: Lighting and Shading
-Tuple Sphere::local_normal_at(float x, float y, float z) {
+Tuple Sphere::local_normal_at(float x, float y, float z) const {
     // Algorithm explanation: p80 - p82
     return local_normal_at(point(x, y, z));
 };
 
-Tuple Sphere::local_normal_at(Tuple p) {
+Tuple Sphere::local_normal_at(const Tuple &p) const {
     // Algorithm explanation: p80 - p82
     return p - point(0, 0, 0);
 };
 
-std::string Sphere::to_string() {
+std::string Sphere::to_string() const {
     return "\nTransform:\n" + transformation.to_string() +
     "\nMaterial: " + material.to_string();
 };
 
-Intersections Sphere::local_intersect(Ray r) {
+Intersections Sphere::local_intersect(const Ray &r) const {
+    Intersections xs;
+    local_intersect_into(r, xs);
+    return xs;
+};
+
+void Sphere::local_intersect_into(const Ray &r, Intersections &xs) const {
     // the vector from the sphere's center to the ray origin
     // Remember: the sphere is centered at the world origin
     Tuple sphere_to_ray = r.get_origin() - point(0, 0, 0);
@@ -49,12 +58,68 @@ Intersections Sphere::local_intersect(Ray r) {
     float discriminant = (b * b) - (4 * a * c);
 
     if (discriminant < 0) {
-        // No intersection, return Intersection of len 0
-        return Intersections();
+        // No intersection
+        return;
     };
     // At least 1 intersection
-    return Intersections(std::vector<Intersection>{
-        Intersection((-b - std::sqrt(discriminant)) / (2 * a), this),
-        Intersection((-b + std::sqrt(discriminant)) / (2 * a), this)
-    });
-};
\ No newline at end of file
+    xs.push_back(Intersection((-b - std::sqrt(discriminant)) / (2 * a), this));
+    xs.push_back(Intersection((-b + std::sqrt(discriminant)) / (2 * a), this));
+};
+
+bool Sphere::local_nearest_hit(const Ray &r, float t_max, float &t) const {
+    return unit_sphere_hit(r.get_origin(), r.get_direction(), t_max, t);
+};
+
+bool Sphere::unit_sphere_hit(const Tuple &origin, const Tuple &direction, float t_max, float &t) {
+    Tuple sphere_to_ray = origin - point(0, 0, 0);
+    float a = direction.dot(direction);
+    float b = 2 * direction.dot(sphere_to_ray);
+    float c = sphere_to_ray.dot(sphere_to_ray) - 1;
+
+    float discriminant = (b * b) - (4 * a * c);
+    if (discriminant < 0) {
+        return false;
+    };
+    float t1 = (-b - std::sqrt(discriminant)) / (2 * a);
+    float t2 = (-b + std::sqrt(discriminant)) / (2 * a);
+    if (t1 >= 0 && t1 < t_max) {
+        t = t1;
+        return true;
+    };
+    if (t2 >= 0 && t2 < t_max) {
+        t = t2;
+        return true;
+    };
+    return false;
+};
+
+// Same test as local_nearest_hit, written without branches so each step
+// runs across all lanes of the packet
+void Sphere::local_nearest_hits(const RayPacket &r, PacketHits &hits) const {
+    const unsigned int n = RayPacket::size;
+    float t_lane[n];
+    bool hit[n];
+    for (unsigned int i = 0; i < n; i++) {
+        float a = r.dx[i] * r.dx[i] + r.dy[i] * r.dy[i] + r.dz[i] * r.dz[i];
+        float b = 2 * (r.dx[i] * r.ox[i] + r.dy[i] * r.oy[i] + r.dz[i] * r.oz[i]);
+        float c = r.ox[i] * r.ox[i] + r.oy[i] * r.oy[i] + r.oz[i] * r.oz[i] - 1;
+        float discriminant = (b * b) - (4 * a * c);
+        float root = std::sqrt(std::max(discriminant, 0.0f));
+        float t1 = (-b - root) / (2 * a);
+        float t2 = (-b + root) / (2 * a);
+        // t2 >= t1, so t1 is only passed over when it is behind the origin
+        float t = (t1 >= 0) ? t1 : t2;
+        t_lane[i] = t;
+        hit[i] = discriminant >= 0 && t >= 0 && t < hits.t[i];
+    };
+    for (unsigned int i = 0; i < n; i++) {
+        if (hit[i] && r.is_active(i)) {
+            hits.t[i] = t_lane[i];
+            hits.object[i] = this;
+        };
+    };
+};
+
+BoundingBox Sphere::local_bounds() const {
+    return BoundingBox(point(-1, -1, -1), point(1, 1, 1));
+};
@@ -2,6 +2,7 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "ray.h"
 #include "material.h"
 #include "intersection.h"
@@ -19,21 +20,28 @@ class Sphere : public Shape {
         float radius;
     public:
         // Methods
-        Sphere(Matrix t = identity_matrix(4), Material m = Material()) : Shape(t, m) {
+        Sphere(const Matrix4 &t = Matrix4(), const Material &m = Material()) : Shape(t, m) {
             this->center = point(0, 0, 0);
             this->radius = 1.0;
         };
         // Sphere(Matrix t) : Sphere(t, Material()) {};
-        Sphere(Material m) : Sphere(identity_matrix(4), m) {};
-        Tuple get_center();
-        float get_radius();
-        Tuple local_normal_at(float x, float y, float z);
-        Tuple local_normal_at(Tuple p);
-        std::string to_string();
+        Sphere(const Material &m) : Sphere(Matrix4(), m) {};
+        const Tuple &get_center() const;
+        float get_radius() const;
+        Tuple local_normal_at(float x, float y, float z) const;
+        Tuple local_normal_at(const Tuple &p) const;
+        std::string to_string() const;
         // TODO: refactor when an intersection is done on a general "object" class
         // rather than just the sphere class.
-        Intersections local_intersect(Ray r);
+        Intersections local_intersect(const Ray &r) const;
+        void local_intersect_into(const Ray &r, Intersections &xs) const;
+        bool local_nearest_hit(const Ray &r, float t_max, float &t) const;
+        // The test behind local_nearest_hit for an object-space ray, callable
+        // without a Sphere or a virtual call
+        static bool unit_sphere_hit(const Tuple &origin, const Tuple &direction, float t_max, float &t);
+        void local_nearest_hits(const RayPacket &r, PacketHits &hits) const;
+        BoundingBox local_bounds() const;
 };
 
-bool operator==(Sphere lhs, Sphere rhs);
-bool operator!=(Sphere lhs, Sphere rhs);
+bool operator==(const Sphere &lhs, const Sphere &rhs);
+bool operator!=(const Sphere &lhs, const Sphere &rhs);
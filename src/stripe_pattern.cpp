@@ -1,31 +1,45 @@
 #include "stripe_pattern.h"
 #include "shape.h"
 
-StripePattern::StripePattern(Color a, Color b, Matrix t) {
+StripePattern::StripePattern(const Color &a, const Color &b, const Matrix4 &t) {
     this->a = a;
     this->b = b;
-    this->transform = t;
+    set_transform(t);
 };
 
-Color StripePattern::get_a() {
+const Color &StripePattern::get_a() const {
     return a;
 };
 
-Color StripePattern::get_b() {
+const Color &StripePattern::get_b() const {
     return b;
 };
 
-Color StripePattern::stripe_at(Tuple p) {
+Color StripePattern::stripe_at(const Tuple &p) const {
     return ((int) std::floor(p.x) % 2 == 0) ? a : b;
 };
 
-void StripePattern::set_transform(Matrix t) {
+void StripePattern::set_transform(const Matrix4 &t) {
+    this->transform = t;
+    this->inverse_transform = t.inverse();
+};
+
+const Matrix4 &StripePattern::get_transform() const {
+    return transform;
+};
+
+void StripePattern::set_transform(const Matrix4 &t, const Matrix4 &inverse) {
     this->transform = t;
+    this->inverse_transform = inverse;
+};
+
+const Matrix4 &StripePattern::get_inverse_transform() const {
+    return inverse_transform;
 };
 
-Color StripePattern::stripe_at_object(Shape * object, Tuple point_) {
-    Tuple obj_point = (*object).get_transform().inverse() * point_;
-    Tuple pattern_point = this->transform.inverse() * obj_point;
+Color StripePattern::stripe_at_object(const Shape * object, const Tuple &point_) const {
+    Tuple obj_point = (*object).get_inverse_transform() * point_;
+    Tuple pattern_point = this->inverse_transform * obj_point;
 
     return stripe_at(pattern_point);
 }
@@ -2,6 +2,7 @@
 
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 
 #include <cmath>
 
@@ -11,13 +12,18 @@ class StripePattern {
     private:
         Color a;
         Color b;
-        Matrix transform;
+        Matrix4 transform;
+        Matrix4 inverse_transform;
     public:
-        StripePattern(Color a, Color b, Matrix t);
-        StripePattern(Color a, Color b) : StripePattern(a, b, identity_matrix(4)) {};
-        Color get_a();
-        Color get_b();
-        void set_transform(Matrix t);
-        Color stripe_at(Tuple p);  // must be a point, not vector
-        Color stripe_at_object(Shape * object, Tuple point_);
+        StripePattern(const Color &a, const Color &b, const Matrix4 &t);
+        StripePattern(const Color &a, const Color &b) : StripePattern(a, b, Matrix4()) {};
+        const Color &get_a() const;
+        const Color &get_b() const;
+        const Matrix4 &get_transform() const;
+        void set_transform(const Matrix4 &t);
+        // For transforms whose inverse is already known, e.g. from a scene cache
+        void set_transform(const Matrix4 &t, const Matrix4 &inverse);
+        const Matrix4 &get_inverse_transform() const;
+        Color stripe_at(const Tuple &p) const;  // must be a point, not vector
+        Color stripe_at_object(const Shape * object, const Tuple &point_) const;
 };
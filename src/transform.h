@@ -17,4 +17,4 @@ Matrix shearing_matrix(float x_y, float x_z, float y_x, float y_z, float z_x, fl
 
 // Chapter 7: Making a Scene
 // Defining a view transform
-Matrix view_transform(Tuple from, Tuple to, Tuple up);
+Matrix view_transform(const Tuple &from, const Tuple &to, const Tuple &up);
@@ -1,12 +1,29 @@
 #pragma once
 
+#include <cmath>
 #include <string>
+#include <ostream>
+#include <stdexcept>
+
+// Vector math is defined inline here so it can be inlined into the render
+// path. When the build enables SSE4.1 (see the 'simd' option in
+// CMakeLists.txt) tuples and colours are operated on as one 128-bit
+// register, otherwise the plain scalar code is used. There are no wider
+// kernels: simd=AVX2 compiles these same SSE4.1 paths with AVX2/FMA flags.
+#if defined(__SSE4_1__)
+    #define RAY_TRACER_SIMD 1
+    #include <immintrin.h>
+#else
+    #define RAY_TRACER_SIMD 0
+#endif
 
 // Chapter 1: Tuples, Vectors and Points
 // Equality test
-bool equalByEpsilon(float a, float b, float epsilon = 0.001);
+inline bool equalByEpsilon(float a, float b, float epsilon = 0.001) {
+    return std::abs(a - b) <= epsilon;
+};
 
-class Tuple {
+class alignas(16) Tuple {
     public:
         // Attributes
         float x;
@@ -17,51 +34,222 @@ class Tuple {
         // TODO: Learn why virtual_cannon.cpp fails to compile when your tuple
         // constructor doesn't have default values
         // Tuple(float x, float y, float z, float w);
-        Tuple(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 0.0f);
-        bool isPoint();
-        bool isVector();
-        float magnitude();
-        Tuple normalize();
-        float dot(Tuple b);
-        Tuple cross(Tuple b);
-        std::string to_string();
-        Tuple reflect(Tuple normal);
+        Tuple(float x = 0.0f, float y = 0.0f, float z = 0.0f, float w = 0.0f)
+            : x(x), y(y), z(z), w(w) {};
+        bool isPoint() const {
+            return equalByEpsilon(w, 1.0);
+        };
+        bool isVector() const {
+            return equalByEpsilon(w, 0.0);
+        };
+        float magnitude() const;
+        Tuple normalize() const;
+        float dot(const Tuple &b) const;
+        Tuple cross(const Tuple &b) const;
+        std::string to_string() const;
+        Tuple reflect(const Tuple &normal) const;
+#if RAY_TRACER_SIMD
+        __m128 load() const {
+            return _mm_load_ps(&x);
+        };
+        static Tuple store(__m128 v) {
+            Tuple result;
+            _mm_store_ps(&result.x, v);
+            return result;
+        };
+#endif
 };
 
 // Functions to create tuples
-Tuple point(float x, float y, float z);
-Tuple vector(float x, float y, float z);
+inline Tuple point(float x, float y, float z) {
+    return Tuple(x, y, z, 1.0);
+};
+
+inline Tuple vector(float x, float y, float z) {
+    return Tuple(x, y, z, 0);
+};
 
 // Arithmetic operators
-bool operator==(Tuple lhs, Tuple rhs);
-Tuple operator+(Tuple lhs, Tuple rhs);
-Tuple operator-(Tuple tup);
-Tuple operator-(Tuple lhs, Tuple rhs);
-Tuple operator*(Tuple tup, float a);
-Tuple operator*(float a, Tuple tup);
-Tuple operator/(Tuple tup, float a);
+inline bool operator==(const Tuple &lhs, const Tuple &rhs) {
+    return equalByEpsilon(lhs.x, rhs.x)
+        && equalByEpsilon(lhs.y, rhs.y)
+        && equalByEpsilon(lhs.z, rhs.z)
+        && equalByEpsilon(lhs.w, rhs.w);
+};
+
+#if RAY_TRACER_SIMD
+
+inline Tuple operator+(const Tuple &lhs, const Tuple &rhs) {
+    return Tuple::store(_mm_add_ps(lhs.load(), rhs.load()));
+};
+
+inline Tuple operator-(const Tuple &tup) {
+    return Tuple::store(_mm_xor_ps(tup.load(), _mm_set1_ps(-0.0f)));
+};
+
+inline Tuple operator-(const Tuple &lhs, const Tuple &rhs) {
+    return Tuple::store(_mm_sub_ps(lhs.load(), rhs.load()));
+};
+
+inline Tuple operator*(const Tuple &tup, float a) {
+    return Tuple::store(_mm_mul_ps(tup.load(), _mm_set1_ps(a)));
+};
+
+inline Tuple operator/(const Tuple &tup, float a) {
+    return Tuple::store(_mm_div_ps(tup.load(), _mm_set1_ps(a)));
+};
+
+inline float Tuple::dot(const Tuple &b) const {
+    return _mm_cvtss_f32(_mm_dp_ps(load(), b.load(), 0xF1));
+};
+
+inline Tuple Tuple::cross(const Tuple &b) const {
+    // (y, z, x) * (b.z, b.x, b.y) - (z, x, y) * (b.y, b.z, b.x); w cancels to 0
+    __m128 a = load();
+    __m128 c = b.load();
+    __m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c_yzx = _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 r = _mm_sub_ps(_mm_mul_ps(a, c_yzx), _mm_mul_ps(a_yzx, c));
+    return Tuple::store(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 0, 2, 1)));
+};
+
+#else
+
+inline Tuple operator+(const Tuple &lhs, const Tuple &rhs) {
+    return Tuple(lhs.x + rhs.x, lhs.y + rhs.y, lhs.z + rhs.z, lhs.w + rhs.w);
+};
+
+inline Tuple operator-(const Tuple &tup) {
+    return Tuple(-tup.x, -tup.y, -tup.z, -tup.w);
+};
+
+inline Tuple operator-(const Tuple &lhs, const Tuple &rhs) {
+    return Tuple(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z, lhs.w - rhs.w);
+};
+
+inline Tuple operator*(const Tuple &tup, float a) {
+    return Tuple(tup.x * a, tup.y * a, tup.z * a, tup.w * a);
+};
+
+inline Tuple operator/(const Tuple &tup, float a) {
+    return Tuple(tup.x / a, tup.y / a, tup.z / a, tup.w / a);
+};
+
+inline float Tuple::dot(const Tuple &b) const {
+    return this->x * b.x
+        + this->y * b.y
+        + this->z * b.z
+        + this->w * b.w;
+};
+
+inline Tuple Tuple::cross(const Tuple &b) const {
+    return vector(
+        this->y * b.z - this->z * b.y,
+        this->z * b.x - this->x * b.z,
+        this->x * b.y - this->y * b.x
+    );
+};
+
+#endif
+
+inline Tuple operator*(float a, const Tuple &tup) {
+    return tup * a;
+};
+
+inline float Tuple::magnitude() const {
+    return std::sqrt(this->dot(*this));
+};
+
+inline Tuple Tuple::normalize() const {
+    return *this / this->magnitude();
+};
+
+// Chapter 6: Light and Shading
+inline Tuple Tuple::reflect(const Tuple &normal) const {
+    if (!isVector() || !normal.isVector()) {
+        throw std::invalid_argument("Both input tuples must be vectors.");
+    };
+    return *this - normal * (2 * this->dot(normal));
+};
 
 // Chapter 7: Making a Scene
 // Defining a view transform
 void PrintTo(const Tuple& m, std::ostream* os);
 
 // Chapter 2: Colors
-class Color {
+// The unused fourth lane keeps colours the same 16-byte shape as tuples so
+// they can share the vector code; it is always zero.
+class alignas(16) Color {
     public:
         // Attributes
         float red, green, blue;
+        float padding;
         // Methods
-        Color(float red = 0.0f, float green = 0.0f, float blue = 0.0f);
-        std::string to_string();
+        Color(float red = 0.0f, float green = 0.0f, float blue = 0.0f)
+            : red(red), green(green), blue(blue), padding(0.0f) {};
+        std::string to_string() const;
+#if RAY_TRACER_SIMD
+        __m128 load() const {
+            return _mm_load_ps(&red);
+        };
+        static Color store(__m128 v) {
+            Color result;
+            _mm_store_ps(&result.red, v);
+            return result;
+        };
+#endif
 };
 
 // Arithmetic operators
-bool operator==(Color lhs, Color rhs);
-Color operator+(Color lhs, Color rhs);
-Color operator-(Color lhs, Color rhs);
-Color operator*(Color color, float a);
-Color operator*(float a, Color color);
-Color operator*(Color lhs, Color rhs);
+inline bool operator==(const Color &lhs, const Color &rhs) {
+    return equalByEpsilon(lhs.red, rhs.red)
+        && equalByEpsilon(lhs.green, rhs.green)
+        && equalByEpsilon(lhs.blue, rhs.blue);
+};
+
+#if RAY_TRACER_SIMD
+
+inline Color operator+(const Color &lhs, const Color &rhs) {
+    return Color::store(_mm_add_ps(lhs.load(), rhs.load()));
+};
+
+inline Color operator-(const Color &lhs, const Color &rhs) {
+    return Color::store(_mm_sub_ps(lhs.load(), rhs.load()));
+};
+
+inline Color operator*(const Color &color, float a) {
+    return Color::store(_mm_mul_ps(color.load(), _mm_set1_ps(a)));
+};
+
+// Hadamard/Schur Product
+inline Color operator*(const Color &lhs, const Color &rhs) {
+    return Color::store(_mm_mul_ps(lhs.load(), rhs.load()));
+};
+
+#else
+
+inline Color operator+(const Color &lhs, const Color &rhs) {
+    return Color(lhs.red + rhs.red, lhs.green + rhs.green, lhs.blue + rhs.blue);
+};
+
+inline Color operator-(const Color &lhs, const Color &rhs) {
+    return Color(lhs.red - rhs.red, lhs.green - rhs.green, lhs.blue - rhs.blue);
+};
+
+inline Color operator*(const Color &color, float a) {
+    return Color(color.red * a, color.green * a, color.blue * a);
+};
+
+// Hadamard/Schur Product
+inline Color operator*(const Color &lhs, const Color &rhs) {
+    return Color(lhs.red * rhs.red, lhs.green * rhs.green, lhs.blue * rhs.blue);
+};
+
+#endif
+
+inline Color operator*(float a, const Color &color) {
+    return color * a;
+};
 
 // Chapter 7: Making a Scene
 // Defining a view transform
@@ -11,56 +11,155 @@
 #include "intersection.h"
 #include "intersections.h"
 #include "computation.h"
+#include "bvh.h"
 
 #include <vector>
 #include <bits/stdc++.h> 
 #include <iostream>
 
 
-World::World(std::vector<Shape *> objects, std::vector<PointLight> lights) {
+World::World(const std::vector<Shape *> &objects, const std::vector<PointLight> &lights) {
     this->objects = objects;
     this->lights = lights;
+    this->light_cutoff = 0;
 };
 
-Intersections World::intersect_world(Ray r) {
-    std::vector<Intersection> initial_intersections;
-    Intersections i_inter;
-    for (int i=0; i<objects.size(); i++) {
-        i_inter = (*objects[i]).intersect(r);
-        for (int j=0; j<i_inter.data.size(); j++) {
-            initial_intersections.push_back(i_inter.data[j]);
+void World::build_bvh() {
+    bvh.build(objects);
+};
+
+bool World::has_bvh() const {
+    return bvh.is_built() && bvh.get_shape_count() == objects.size();
+};
+
+void World::build_shape_arrays() {
+    shape_arrays.build(objects);
+};
+
+bool World::has_shape_arrays() const {
+    return shape_arrays.is_built() && shape_arrays.get_shape_count() == objects.size();
+};
+
+Intersections World::intersect_world(const Ray &r) const {
+    // Shapes append straight into one list, which stays inline for
+    // typical worlds
+    Intersections xs;
+    if (has_bvh()) {
+        float inf = std::numeric_limits<float>::infinity();
+        bvh.intersect(r, xs, -inf, inf);
+    } else {
+        for (Shape * shape : objects) {
+            (*shape).intersect_into(r, xs);
         }
     }
-    std::sort(
-        initial_intersections.begin(),
-        initial_intersections.end()
-    );
-    return Intersections(initial_intersections);
-};
-
-Color World::shade_hit(Computation comp) {
-    bool shadowed = is_shadowed(comp.over_point);
-    return (*comp.object).get_material().lighting(
-        comp.object,
-        lights[0],  // TODO: Fix this when using multiple light sources! Extra chapter
-        comp.over_point,
-        comp.eyev,
-        comp.normalv,
-        shadowed
-    );
+    xs.sort();
+    return xs;
+};
+
+// Nearest non-negative hit, tracked while iterating shapes so no
+// Intersections list has to be built and sorted. Use intersect_world when
+// every hit is needed.
+Intersection World::closest_hit(const Ray &r) const {
+    if (has_bvh()) {
+        return bvh.closest_hit(r);
+    };
+    if (has_shape_arrays()) {
+        return shape_arrays.closest_hit(r);
+    };
+    float t_max = std::numeric_limits<float>::infinity();
+    Shape * closest = NULL;
+    float t;
+    for (Shape * shape : objects) {
+        if ((*shape).nearest_hit(r, t_max, t)) {
+            t_max = t;
+            closest = shape;
+        };
+    };
+    return (closest == NULL) ? Intersection() : Intersection(t_max, closest);
+};
+
+void World::closest_hits(const RayPacket &r, PacketHits &hits) const {
+    if (has_bvh()) {
+        bvh.closest_hits(r, hits);
+        return;
+    };
+    if (has_shape_arrays()) {
+        for (unsigned int i=0; i<RayPacket::size; i++) {
+            Intersection h = r.is_active(i) ? shape_arrays.closest_hit(r.get_ray(i)) : Intersection();
+            if (!h.is_empty() && h.t < hits.t[i]) {
+                hits.t[i] = h.t;
+                hits.object[i] = h.object;
+            };
+        };
+        return;
+    };
+    for (Shape * shape : objects) {
+        (*shape).nearest_hits(r, hits);
+    };
+};
+
+// The contributions of every light are summed. Shadow rays are the main
+// cost per light, so each light is first culled: one behind the surface
+// adds only ambient light whether it is blocked or not, and one whose
+// diffuse and specular light can't reach light_cutoff is treated as
+// shadowed. Only the remaining lights trace a shadow ray.
+Color World::shade_hit(const Computation &comp) const {
+    const Material &material = (*comp.object).get_material();
+    Color base_color = material.base_color_at(comp.object, comp.over_point);
+    Color result;
+    for (const PointLight &light : lights) {
+        Tuple direction = light.get_position() - comp.over_point;
+        float distance = direction.magnitude();
+        float light_dot_normal = direction.dot(comp.normalv) / distance;
+        bool shadowed = true;
+        if (light_dot_normal >= 0) {
+            // Upper bound on diffuse + specular, taking colour channels as at most 1
+            const Color &intensity = light.get_intensity();
+            float brightest = std::max(intensity.red, std::max(intensity.green, intensity.blue));
+            float bound = brightest * (material.diffuse * light_dot_normal + material.specular);
+            shadowed = bound < light_cutoff
+                || is_occluded(Ray(comp.over_point, direction / distance), distance);
+        };
+        result = result + material.lighting(
+            base_color,
+            light,
+            comp.over_point,
+            comp.eyev,
+            comp.normalv,
+            shadowed
+        );
+    };
+    return result;
 };
 
 // p113
-bool World::is_shadowed(Tuple p) {
-    // TODO: replace with multiple light sources
-    Tuple direction = lights[0].get_position() - p;
+bool World::is_shadowed(const Tuple &p) const {
+    return is_shadowed(p, lights[0]);
+};
+
+bool World::is_shadowed(const Tuple &p, const PointLight &light) const {
+    Tuple direction = light.get_position() - p;
     float distance = direction.magnitude();
     Ray r(p, direction.normalize());
 
-    Intersections i = intersect_world(r);
-    Intersection hit = i.hit();
+    return is_occluded(r, distance);
+};
 
-    return !hit.is_empty() && hit.t < distance;
+// Any-hit query for shadow rays: stops at the first shape hit with
+// 0 <= t < distance instead of collecting and sorting every intersection.
+bool World::is_occluded(const Ray &r, float distance) const {
+    if (has_bvh()) {
+        return bvh.occluded(r, distance);
+    };
+    if (has_shape_arrays()) {
+        return shape_arrays.occluded(r, distance);
+    };
+    for (Shape * shape : objects) {
+        if ((*shape).occludes(r, distance)) {
+            return true;
+        };
+    };
+    return false;
 };
 
 
@@ -84,9 +183,8 @@ World default_world() {
     );
 };
 
-Color World::color_at(Ray r) {
-    Intersections i = intersect_world(r);
-    Intersection h = i.hit();
+Color World::color_at(const Ray &r) const {
+    Intersection h = closest_hit(r);
 
     if (h.is_empty()) {
         return Color();
@@ -96,3 +194,24 @@ Color World::color_at(Ray r) {
 
     return shade_hit(comp);
 };
+
+void World::colors_at(const RayPacket &r, Color *colors) const {
+    PacketHits hits;
+    closest_hits(r, hits);
+    shade_hits(r, hits, colors);
+};
+
+void World::shade_hits(const RayPacket &r, const PacketHits &hits, Color *colors) const {
+    for (unsigned int i=0; i<RayPacket::size; i++) {
+        if (!r.is_active(i)) {
+            continue;
+        };
+        Intersection h = hits.get(i);
+        if (h.is_empty()) {
+            colors[i] = Color();
+            continue;
+        };
+        Computation comp = h.prepare_computations(r.get_ray(i));
+        colors[i] = shade_hit(comp);
+    };
+};
@@ -9,6 +9,9 @@
 #include "intersection.h"
 #include "intersections.h"
 #include "computation.h"
+#include "bvh.h"
+#include "shape_arrays.h"
+#include "ray_packet.h"
 
 #include <vector>
 
@@ -17,13 +20,39 @@ class World {
     public:
         std::vector<Shape *> objects;
         std::vector<PointLight> lights;
-        World(std::vector<Shape *> objects = std::vector<Shape *>{}, std::vector<PointLight> lights = std::vector<PointLight>{});
-        World(Shape * s, PointLight l) : World(std::vector<Shape *> (1, s), std::vector<PointLight> {1, l})  {};
-        World(std::vector<Shape *> s_list, PointLight l) : World(s_list, std::vector<PointLight> {1, l})  {};
-        Intersections intersect_world(Ray r);
-        Color shade_hit(Computation comp);
-        Color color_at(Ray r);
-        bool is_shadowed(Tuple p);
+        // Lights whose diffuse and specular contribution at a point can't
+        // reach this value are treated as shadowed there, skipping their
+        // shadow ray. 0 culls only lights facing away from the surface.
+        float light_cutoff;
+        // Built by build_bvh(); stale once objects or their transforms change
+        BVH bvh;
+        World(const std::vector<Shape *> &objects = std::vector<Shape *>{}, const std::vector<PointLight> &lights = std::vector<PointLight>{});
+        World(Shape * s, const PointLight &l) : World(std::vector<Shape *> (1, s), std::vector<PointLight> {1, l})  {};
+        World(const std::vector<Shape *> &s_list, const PointLight &l) : World(s_list, std::vector<PointLight> {1, l})  {};
+        // Optional devirtualized copy of the object list, see shape_arrays.h.
+        // Used for queries when there is no BVH; suits small scenes.
+        // Built by build_shape_arrays(); stale once objects or their transforms change
+        ShapeArrays shape_arrays;
+        void build_bvh();
+        // True when bvh was built from the current object list
+        bool has_bvh() const;
+        void build_shape_arrays();
+        // True when shape_arrays was built from the current object list
+        bool has_shape_arrays() const;
+        Intersections intersect_world(const Ray &r) const;
+        Intersection closest_hit(const Ray &r) const;
+        // Packet forms of closest_hit and color_at for every active lane;
+        // colors[lane] is left untouched for inactive lanes
+        void closest_hits(const RayPacket &r, PacketHits &hits) const;
+        void colors_at(const RayPacket &r, Color *colors) const;
+        // Second half of colors_at: shades hits found by closest_hits
+        void shade_hits(const RayPacket &r, const PacketHits &hits, Color *colors) const;
+        Color shade_hit(const Computation &comp) const;
+        Color color_at(const Ray &r) const;
+        // Shadow test towards the first light
+        bool is_shadowed(const Tuple &p) const;
+        bool is_shadowed(const Tuple &p, const PointLight &light) const;
+        bool is_occluded(const Ray &r, float distance) const;
 };
 
 World default_world();
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "ray_tracer.h"
+#include "gtest/gtest.h"
+#include <math.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+// Bonus chapter: Bounding boxes and hierarchies
+// Scenario: Creating an empty bounding box
+TEST (TestBoundingBox, EmptyBox) {
+    BoundingBox box = BoundingBox();
+
+    EXPECT_TRUE(box.is_empty());
+    EXPECT_FALSE(box.is_infinite());
+}
+
+// Scenario: Adding points to an empty bounding box
+TEST (TestBoundingBox, AddingPoints) {
+    BoundingBox box = BoundingBox();
+    box.add_point(point(-5, 2, 0));
+    box.add_point(point(7, 0, -3));
+
+    EXPECT_EQ(box.min, point(-5, 0, -3));
+    EXPECT_EQ(box.max, point(7, 2, 0));
+}
+
+// Scenario: A sphere has a bounding box
+TEST (TestBoundingBox, SphereBounds) {
+    Sphere s = Sphere();
+    BoundingBox box = s.local_bounds();
+
+    EXPECT_EQ(box.min, point(-1, -1, -1));
+    EXPECT_EQ(box.max, point(1, 1, 1));
+}
+
+// Scenario: A plane has an unbounded bounding box
+TEST (TestBoundingBox, PlaneBounds) {
+    Plane p = Plane();
+
+    EXPECT_TRUE(p.local_bounds().is_infinite());
+    EXPECT_TRUE(p.bounds().is_infinite());
+}
+
+// Scenario: Querying a shape's bounding box in world space
+TEST (TestBoundingBox, TransformedSphereBounds) {
+    Sphere s = Sphere();
+    s.set_transform(translation_matrix(1, -3, 5) * scaling_matrix(0.5, 2, 4));
+    BoundingBox box = s.bounds();
+
+    EXPECT_EQ(box.min, point(0.5, -5, 1));
+    EXPECT_EQ(box.max, point(1.5, -1, 9));
+}
+
+// Scenario: Transforming a bounding box
+TEST (TestBoundingBox, RotatedBox) {
+    BoundingBox box = BoundingBox(point(-1, -1, -1), point(1, 1, 1));
+    BoundingBox rotated = box.transform(rotation_x_matrix(M_PI / 4) * rotation_y_matrix(M_PI / 4));
+
+    EXPECT_EQ(rotated.min, point(-1.4142, -1.7071, -1.7071));
+    EXPECT_EQ(rotated.max, point(1.4142, 1.7071, 1.7071));
+}
+
+// Scenario: Intersecting a ray with a bounding box
+TEST (TestBoundingBox, IntersectingRay) {
+    BoundingBox box = BoundingBox(point(5, -2, 0), point(11, 4, 7));
+    float inf = std::numeric_limits<float>::infinity();
+    struct Example {
+        Tuple origin;
+        Tuple direction;
+        bool result;
+    };
+    std::vector<Example> examples = {
+        {point(15, 1, 2), vector(-1, 0, 0), true},
+        {point(-5, -1, 4), vector(1, 0, 0), true},
+        {point(7, 6, 5), vector(0, -1, 0), true},
+        {point(9, -5, 6), vector(0, 1, 0), true},
+        {point(8, 2, 12), vector(0, 0, -1), true},
+        {point(6, 0, -5), vector(0, 0, 1), true},
+        {point(8, 1, 3.5), vector(0, 0, 1), true},
+        {point(9, -1, -8), vector(2, 4, 6).normalize(), false},
+        {point(8, 3, -4), vector(6, 2, 4).normalize(), false},
+        {point(9, -1, -2), vector(4, 6, 2).normalize(), false},
+        {point(4, 0, 9), vector(0, 0, -1), false},
+        {point(8, 6, -1), vector(0, -1, 0), false},
+        {point(12, 5, 4), vector(-1, 0, 0), false},
+    };
+    for (Example e : examples) {
+        Tuple inv = vector(1 / e.direction.x, 1 / e.direction.y, 1 / e.direction.z);
+        EXPECT_EQ(box.intersects(e.origin, inv, -inf, inf), e.result);
+    }
+}
+
+// Scenario: A bounding box behind the ray is culled by the t range
+TEST (TestBoundingBox, IntersectingRayWithinRange) {
+    BoundingBox box = BoundingBox(point(-1, -1, -1), point(1, 1, 1));
+    Tuple inv = vector(std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), 1);
+
+    EXPECT_TRUE(box.intersects(point(0, 0, -5), inv, 0, 100));
+    EXPECT_FALSE(box.intersects(point(0, 0, 5), inv, 0, 100));
+    EXPECT_FALSE(box.intersects(point(0, 0, -5), inv, 0, 3));
+}
+
+// Scenario: Intersecting a world through its BVH matches testing every object
+TEST (TestBVH, MatchesLinearIntersection) {
+    std::vector<Sphere> spheres(200);
+    World w = World();
+    Plane floor = Plane();
+    w.objects.push_back(&floor);
+    for (unsigned int i = 0; i < spheres.size(); i++) {
+        float x = (i % 10) * 1.5 - 7;
+        float y = (i / 10 % 5) * 1.5;
+        float z = (i / 50) * 1.5;
+        spheres[i].set_transform(translation_matrix(x, y, z) * scaling_matrix(0.5, 0.5, 0.5));
+        w.objects.push_back(&spheres[i]);
+    }
+
+    std::vector<Ray> rays;
+    for (int i = 0; i < 50; i++) {
+        rays.push_back(Ray(point(0, 3, -10), vector(0.02 * i - 0.5, -0.1 + 0.005 * i, 1).normalize()));
+    }
+
+    std::vector<Intersections> expected;
+    for (Ray r : rays) {
+        expected.push_back(w.intersect_world(r));
+    }
+
+    w.build_bvh();
+    EXPECT_TRUE(w.bvh.is_built());
+    EXPECT_GT(w.bvh.get_node_count(), 1);
+
+    for (unsigned int i = 0; i < rays.size(); i++) {
+        Intersections actual = w.intersect_world(rays[i]);
+        ASSERT_EQ(actual.count, expected[i].count);
+        for (int j = 0; j < actual.count; j++) {
+            EXPECT_TRUE(equalByEpsilon(actual[j].t, expected[i][j].t));
+        }
+        EXPECT_EQ(actual.hit().object, expected[i].hit().object);
+        EXPECT_EQ(w.closest_hit(rays[i]).object, expected[i].hit().object);
+    }
+}
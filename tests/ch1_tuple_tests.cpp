@@ -216,4 +216,71 @@ TEST (TestTuples, CrossProductOfRandomTuples) {
     Tuple b8 = vector(2, 3, 4);
     EXPECT_TRUE(vector(-1, 2, -1) == a8.cross(b8));
     EXPECT_TRUE(vector(1, -2, 1) == b8.cross(a8));
-}
\ No newline at end of file
+}
+
+// Scenario: Tuples and colours are laid out as one 16-byte vector
+// (not in book)
+TEST (TestTuples, VectorLayout) {
+    EXPECT_EQ(sizeof(Tuple), 16);
+    EXPECT_EQ(alignof(Tuple), 16);
+    EXPECT_EQ(sizeof(Color), 16);
+    EXPECT_EQ(alignof(Color), 16);
+    Color c = Color(0.9, 0.6, 0.75) * Color(0.7, 0.1, 0.25) + Color(1, 1, 1);
+    EXPECT_FLOAT_EQ(c.padding, 0.0f);
+}
+
+// Scenario: Vector math matches the scalar definitions
+// (not in book)
+TEST (TestTuples, VectorMathMatchesScalar) {
+    // Expected values are worked out on plain floats, never through the
+    // Tuple/Color operators under test. Lane-wise ops must match exactly;
+    // the reductions may round differently (e.g. FMA contraction).
+    const float ax = 1.5f, ay = -2.0f, az = 3.25f, aw = 1.0f;
+    const float bx = -0.5f, by = 4.0f, bz = 2.0f, bw = 0.0f;
+    const float s = 0.3f;
+    Tuple a = Tuple(ax, ay, az, aw);
+    Tuple b = Tuple(bx, by, bz, bw);
+    auto expect_exact = [](const Tuple &t, float x, float y, float z, float w) {
+        EXPECT_EQ(t.x, x);
+        EXPECT_EQ(t.y, y);
+        EXPECT_EQ(t.z, z);
+        EXPECT_EQ(t.w, w);
+    };
+
+    expect_exact(a + b, ax + bx, ay + by, az + bz, aw + bw);
+    expect_exact(a - b, ax - bx, ay - by, az - bz, aw - bw);
+    expect_exact(-a, -ax, -ay, -az, -aw);
+    expect_exact(a * s, ax * s, ay * s, az * s, aw * s);
+    expect_exact(s * a, ax * s, ay * s, az * s, aw * s);
+    expect_exact(a / s, ax / s, ay / s, az / s, aw / s);
+
+    EXPECT_FLOAT_EQ(a.dot(b), ax * bx + ay * by + az * bz + aw * bw);
+    Tuple cross = a.cross(b);
+    EXPECT_FLOAT_EQ(cross.x, ay * bz - az * by);
+    EXPECT_FLOAT_EQ(cross.y, az * bx - ax * bz);
+    EXPECT_FLOAT_EQ(cross.z, ax * by - ay * bx);
+    EXPECT_EQ(cross.w, 0.0f);
+    float length = std::sqrt(bx * bx + by * by + bz * bz + bw * bw);
+    EXPECT_FLOAT_EQ(b.magnitude(), length);
+    Tuple unit = b.normalize();
+    EXPECT_FLOAT_EQ(unit.x, bx / length);
+    EXPECT_FLOAT_EQ(unit.y, by / length);
+    EXPECT_FLOAT_EQ(unit.z, bz / length);
+    EXPECT_EQ(unit.w, 0.0f);
+
+    const float cr = 0.9f, cg = 0.6f, cb = 0.75f;
+    const float dr = 0.7f, dg = 0.1f, db = 0.25f;
+    Color c = Color(cr, cg, cb);
+    Color d = Color(dr, dg, db);
+    auto expect_color = [](const Color &color, float red, float green, float blue) {
+        EXPECT_EQ(color.red, red);
+        EXPECT_EQ(color.green, green);
+        EXPECT_EQ(color.blue, blue);
+        EXPECT_EQ(color.padding, 0.0f);
+    };
+    expect_color(c + d, cr + dr, cg + dg, cb + db);
+    expect_color(c - d, cr - dr, cg - dg, cb - db);
+    expect_color(c * d, cr * dr, cg * dg, cb * db);
+    expect_color(c * s, cr * s, cg * s, cb * s);
+    expect_color(s * c, cr * s, cg * s, cb * s);
+}
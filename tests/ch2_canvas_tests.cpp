@@ -1,8 +1,178 @@
 #include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include <stdexcept>
 #include "tuple.h"
 #include "canvas.h"
+#include "png.h"
 #include "gtest/gtest.h"
 
+// Minimal inflate covering the block types encode_png emits: stored (00) and
+// fixed Huffman (01). Throws if the stream uses anything else.
+static std::vector<uint8_t> inflate_fixed(const uint8_t *data, std::size_t size) {
+    static const uint16_t length_base[29] = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const uint8_t length_extra[29] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    static const uint16_t distance_base[30] = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    static const uint8_t distance_extra[30] = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+
+    std::size_t bit = 0;
+    auto bits = [&](unsigned int count) {
+        uint32_t value = 0;
+        for (unsigned int i = 0; i < count; i++) {
+            if (bit / 8 >= size) {
+                throw std::runtime_error("deflate stream truncated");
+            };
+            value |= ((data[bit / 8] >> (bit % 8)) & 1u) << i;
+            bit++;
+        };
+        return value;
+    };
+    // Huffman codes are packed most significant bit first
+    auto code = [&](unsigned int count, uint32_t prefix) {
+        for (unsigned int i = 0; i < count; i++) {
+            prefix = (prefix << 1) | bits(1);
+        };
+        return prefix;
+    };
+
+    std::vector<uint8_t> out;
+    bool final = false;
+    while (!final) {
+        final = bits(1) == 1;
+        uint32_t type = bits(2);
+        if (type == 0) {
+            bit = (bit + 7) / 8 * 8;
+            uint32_t length = bits(16);
+            uint32_t complement = bits(16);
+            if ((length ^ 0xFFFF) != complement || bit / 8 + length > size) {
+                throw std::runtime_error("bad stored block");
+            };
+            out.insert(out.end(), data + bit / 8, data + bit / 8 + length);
+            bit += length * 8;
+            continue;
+        };
+        if (type != 1) {
+            throw std::runtime_error("unexpected block type");
+        };
+        while (true) {
+            uint32_t symbol = code(7, 0);
+            if (symbol <= 0x17) {
+                symbol += 256;
+            } else {
+                symbol = code(1, symbol);
+                if (symbol >= 0x30 && symbol <= 0xBF) {
+                    symbol -= 0x30;
+                } else if (symbol >= 0xC0 && symbol <= 0xC7) {
+                    symbol = symbol - 0xC0 + 280;
+                } else {
+                    symbol = code(1, symbol) - 0x190 + 144;
+                };
+            };
+            if (symbol < 256) {
+                out.push_back(symbol);
+                continue;
+            };
+            if (symbol == 256) {
+                break;
+            };
+            symbol -= 257;
+            if (symbol >= 29) {
+                throw std::runtime_error("bad length symbol");
+            };
+            uint32_t length = length_base[symbol] + bits(length_extra[symbol]);
+            uint32_t distance_symbol = code(5, 0);
+            if (distance_symbol >= 30) {
+                throw std::runtime_error("bad distance symbol");
+            };
+            uint32_t distance = distance_base[distance_symbol] + bits(distance_extra[distance_symbol]);
+            if (distance > out.size()) {
+                throw std::runtime_error("distance before start of output");
+            };
+            for (uint32_t i = 0; i < length; i++) {
+                out.push_back(out[out.size() - distance]);
+            };
+        };
+    };
+    return out;
+}
+
+static uint32_t read_u32(const uint8_t *bytes) {
+    return ((uint32_t) bytes[0] << 24) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 8) | bytes[3];
+}
+
+// Walks the chunks (checking each CRC), inflates the IDAT stream (checking
+// its Adler-32) and undoes the per-row filters, returning the RGB bytes.
+static std::vector<uint8_t> decode_png(const std::vector<uint8_t> &png, unsigned int &width, unsigned int &height) {
+    std::vector<uint8_t> idat;
+    std::size_t at = 8;
+    while (at + 12 <= png.size()) {
+        uint32_t length = read_u32(&png[at]);
+        std::string type(png.begin() + at + 4, png.begin() + at + 8);
+        EXPECT_EQ(crc32(&png[at + 4], length + 4), read_u32(&png[at + 8 + length])) << type;
+        if (type == "IHDR") {
+            width = read_u32(&png[at + 8]);
+            height = read_u32(&png[at + 12]);
+        } else if (type == "IDAT") {
+            idat.insert(idat.end(), png.begin() + at + 8, png.begin() + at + 8 + length);
+        };
+        at += 12 + length;
+    };
+    EXPECT_EQ(at, png.size());
+
+    EXPECT_EQ((idat[0] * 256 + idat[1]) % 31, 0);
+    std::vector<uint8_t> filtered = inflate_fixed(idat.data() + 2, idat.size() - 6);
+    EXPECT_EQ(adler32(filtered.data(), filtered.size()), read_u32(&idat[idat.size() - 4]));
+
+    std::size_t stride = (std::size_t) width * 3;
+    EXPECT_EQ(filtered.size(), (stride + 1) * height);
+    std::vector<uint8_t> rgb(stride * height);
+    for (unsigned int y = 0; y < height; y++) {
+        uint8_t type = filtered[y * (stride + 1)];
+        const uint8_t *in = &filtered[y * (stride + 1) + 1];
+        uint8_t *row = &rgb[y * stride];
+        const uint8_t *above = (y > 0) ? row - stride : NULL;
+        for (std::size_t i = 0; i < stride; i++) {
+            int a = (i >= 3) ? row[i - 3] : 0;
+            int b = (above != NULL) ? above[i] : 0;
+            int c = (i >= 3 && above != NULL) ? above[i - 3] : 0;
+            int predictor = 0;
+            switch (type) {
+                case 0: predictor = 0; break;
+                case 1: predictor = a; break;
+                case 2: predictor = b; break;
+                case 3: predictor = (a + b) / 2; break;
+                case 4: {
+                    int p = a + b - c;
+                    int pa = std::abs(p - a);
+                    int pb = std::abs(p - b);
+                    int pc = std::abs(p - c);
+                    predictor = (pa <= pb && pa <= pc) ? a : (pb <= pc) ? b : c;
+                    break;
+                };
+                default: ADD_FAILURE() << "bad filter type " << (int) type;
+            };
+            row[i] = in[i] + predictor;
+        };
+    };
+    return rgb;
+}
+
 // Scenario: Colors are (red, green, blue) tuples
 // p16
 TEST (TestColors, ColorsAreTuples) {
@@ -92,3 +262,196 @@ TEST (TestCanvas, EndPPMStringWithNewline) {
     std::string ppm = canvas_5.canvas_to_ppm();
     EXPECT_TRUE(ppm.back() == '\n');
 }
+
+// Scenario: Rows expose the pixels written to the canvas
+// pMe
+TEST (TestCanvas, RowAccessMatchesPixels) {
+    Canvas canvas_6(4, 3);
+    Color red(1, 0, 0), blue(0, 0, 1);
+    canvas_6.write_pixel(red, 2, 1);
+    canvas_6.row(2)[3] = blue;
+    EXPECT_TRUE(canvas_6.row(1)[2] == red);
+    EXPECT_TRUE(canvas_6.pixel_at(3, 2) == blue);
+    EXPECT_TRUE(canvas_6.row(1) + 4 == canvas_6.row(2));
+}
+
+// Scenario: Writing a PPM file produces the same P3 text as canvas_to_ppm by default
+// pMe
+TEST (TestCanvas, WriteP3FileMatchesString) {
+    Canvas canvas_7(10, 2);
+    canvas_7.write_pixel(Color(1, 0.8, 0.6), 3, 1);
+    canvas_7.write_to_ppm("test_canvas_p3.ppm");
+
+    std::ifstream in("test_canvas_p3.ppm", std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove("test_canvas_p3.ppm");
+
+    EXPECT_TRUE(contents.str() == canvas_7.canvas_to_ppm());
+}
+
+// Scenario: Writing a P6 file stores one byte per channel after the header
+// pMe
+TEST (TestCanvas, WriteP6File) {
+    Canvas canvas_8(5, 3);
+    canvas_8.write_pixel(Color(1.5, 0, 0), 0, 0);
+    canvas_8.write_pixel(Color(0, 0.5, 0), 2, 1);
+    canvas_8.write_pixel(Color(-0.5, 0, 1), 4, 2);
+    canvas_8.write_to_ppm("test_canvas_p6.ppm", PPMFormat::P6);
+
+    std::ifstream in("test_canvas_p6.ppm", std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove("test_canvas_p6.ppm");
+
+    std::string header = "P6\n5 3\n255\n";
+    std::string data = contents.str();
+    ASSERT_EQ(data.size(), header.size() + 5 * 3 * 3);
+    EXPECT_TRUE(data.substr(0, header.size()) == header);
+    const unsigned char * pixels = (const unsigned char *) data.data() + header.size();
+    EXPECT_EQ(pixels[0], 255);
+    EXPECT_EQ(pixels[(1 * 5 + 2) * 3 + 1], 128);
+    EXPECT_EQ(pixels[(2 * 5 + 4) * 3 + 2], 255);
+    EXPECT_EQ(pixels[(2 * 5 + 4) * 3], 0);
+}
+
+// Scenario: A PPM file that can't be written in full throws
+// pMe
+TEST (TestCanvas, WriteFailureThrows) {
+    std::FILE * probe = std::fopen("/dev/full", "wb");
+    if (probe == NULL) {
+        GTEST_SKIP() << "no /dev/full on this platform";
+    };
+    std::fclose(probe);
+    Canvas canvas_8(300, 300);
+    // A full device accepts the open but fails the writes
+    EXPECT_THROW(canvas_8.write_to_ppm("/dev/full"), std::runtime_error);
+    EXPECT_THROW(canvas_8.write_to_ppm("/dev/full", PPMFormat::P6), std::runtime_error);
+}
+
+// Scenario: Cropping a block out of a canvas and pasting it back
+// pMe
+TEST (TestCanvas, CropAndPaste) {
+    Canvas canvas(5, 4);
+    canvas.write_pixel(Color(1, 0, 0), 1, 1);
+    canvas.write_pixel(Color(0, 1, 0), 3, 2);
+
+    Canvas block = canvas.crop(1, 1, 3, 2);
+    EXPECT_EQ(block.get_width(), 3);
+    EXPECT_EQ(block.get_height(), 2);
+    EXPECT_EQ(block.pixel_at(0, 0), Color(1, 0, 0));
+    EXPECT_EQ(block.pixel_at(2, 1), Color(0, 1, 0));
+
+    Canvas target(5, 4);
+    target.paste(block, 2, 2);
+    EXPECT_EQ(target.pixel_at(2, 2), Color(1, 0, 0));
+    EXPECT_EQ(target.pixel_at(4, 3), Color(0, 1, 0));
+    EXPECT_EQ(target.pixel_at(1, 1), Color(0, 0, 0));
+
+    EXPECT_THROW(canvas.crop(3, 0, 3, 1), std::invalid_argument);
+    EXPECT_THROW(target.paste(block, 3, 0), std::invalid_argument);
+}
+
+// Scenario: PNG checksums match their reference values
+// pMe
+TEST (TestPNG, Checksums) {
+    std::string crc_input = "123456789";
+    std::string adler_input = "Wikipedia";
+    EXPECT_EQ(crc32((const uint8_t *) crc_input.data(), crc_input.size()), 0xCBF43926u);
+    EXPECT_EQ(adler32((const uint8_t *) adler_input.data(), adler_input.size()), 0x11E60398u);
+}
+
+// Scenario: Encoding a canvas produces the PNG signature, header and end chunk
+// pMe
+TEST (TestPNG, EncodedStructure) {
+    std::vector<uint8_t> rgb(7 * 5 * 3, 200);
+    for (unsigned int threads : {1u, 3u}) {
+        std::vector<uint8_t> png = encode_png(7, 5, rgb, threads);
+
+        std::vector<uint8_t> signature = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        EXPECT_TRUE(std::equal(signature.begin(), signature.end(), png.begin()));
+        EXPECT_TRUE(std::string(png.begin() + 12, png.begin() + 16) == "IHDR");
+        EXPECT_EQ(png[19], 7);   // width
+        EXPECT_EQ(png[23], 5);   // height
+        EXPECT_EQ(png[24], 8);   // bit depth
+        EXPECT_EQ(png[25], 2);   // RGB
+
+        // IEND with its fixed CRC closes the file
+        std::vector<uint8_t> iend = {0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82};
+        EXPECT_TRUE(std::equal(iend.begin(), iend.end(), png.end() - 12));
+    }
+}
+
+// Scenario: Decoding an encoded PNG gives back the input pixels
+// pMe
+TEST (TestPNG, RoundTrip) {
+    const unsigned int width = 37;
+    const unsigned int height = 23;
+    std::vector<uint8_t> rgb(width * height * 3);
+    uint32_t state = 12345;
+    for (unsigned int y = 0; y < height; y++) {
+        for (unsigned int x = 0; x < width; x++) {
+            uint8_t *pixel = &rgb[(y * width + x) * 3];
+            if (y < 8) {
+                // Flat band and gradients give long matches
+                pixel[0] = (x < 20) ? 200 : x * 7;
+                pixel[1] = y * 11;
+                pixel[2] = 90;
+            } else {
+                // Noise forces literals of every code length
+                state = state * 1103515245u + 12345u;
+                pixel[0] = state >> 24;
+                pixel[1] = state >> 16;
+                pixel[2] = (y < 16) ? (state >> 8) : pixel[0];
+            };
+        };
+    };
+    for (unsigned int threads : {1u, 3u, 64u}) {
+        unsigned int decoded_width = 0;
+        unsigned int decoded_height = 0;
+        std::vector<uint8_t> decoded = decode_png(encode_png(width, height, rgb, threads), decoded_width, decoded_height);
+        EXPECT_EQ(decoded_width, width);
+        EXPECT_EQ(decoded_height, height);
+        EXPECT_TRUE(decoded == rgb) << "threads " << threads;
+    }
+
+    // A canvas written to disk decodes to its scaled colors
+    Canvas canvas_8(3, 2);
+    canvas_8.write_pixel(Color(1, 0, 0), 0, 0);
+    canvas_8.write_pixel(Color(0, 0.5, 0), 1, 0);
+    canvas_8.write_pixel(Color(-1, 0.2, 2), 2, 1);
+    canvas_8.write_to_png("test_canvas_roundtrip.png");
+
+    std::ifstream in("test_canvas_roundtrip.png", std::ios::binary);
+    std::stringstream contents;
+    contents << in.rdbuf();
+    in.close();
+    std::remove("test_canvas_roundtrip.png");
+
+    std::string data = contents.str();
+    std::vector<uint8_t> png(data.begin(), data.end());
+    unsigned int decoded_width = 0;
+    unsigned int decoded_height = 0;
+    std::vector<uint8_t> decoded = decode_png(png, decoded_width, decoded_height);
+    std::vector<uint8_t> expected = {
+        255, 0, 0,  0, 128, 0,  0, 0, 0,
+        0, 0, 0,  0, 0, 0,  0, 51, 255
+    };
+    EXPECT_TRUE(decoded == expected);
+}
+
+// Scenario: A PNG file that can't be written in full throws
+// pMe
+TEST (TestPNG, WriteFailureThrows) {
+    std::FILE * probe = std::fopen("/dev/full", "wb");
+    if (probe == NULL) {
+        GTEST_SKIP() << "no /dev/full on this platform";
+    };
+    std::fclose(probe);
+    // A full device accepts the open but fails the write or the close
+    Canvas canvas_8(300, 300);
+    EXPECT_THROW(canvas_8.write_to_png("/dev/full"), std::runtime_error);
+    EXPECT_THROW(canvas_8.write_to_png("/dev/full", 3), std::runtime_error);
+}
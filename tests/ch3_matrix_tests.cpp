@@ -3,6 +3,7 @@
 #include <iostream>
 #include "tuple.h"
 #include "matrix.h"
+#include "fixed_matrix.h"
 #include "gtest/gtest.h"
 
 
@@ -720,3 +721,93 @@ TEST (TestMatrices, InverseAndTranspose) {
     
     EXPECT_EQ(a.inverse().transpose(), a.transpose().inverse());
 }
+
+// Scenario: A fixed-size 4x4 matrix matches the generic matrix it was built from
+// pMe
+TEST (TestFixedMatrices, ConvertingFromGenericMatrix) {
+    std::vector<float> a_data = { 9, 3,  0,  9,
+                                 -5,  -2,  -6,  -3,
+                                -4,  9,  6,  4,
+                                -7,  6, 6, 2};
+    Matrix a(4, 4, a_data);
+    Matrix4 fixed = a;
+
+    EXPECT_TRUE(equalByEpsilon(fixed.get_point(1, 2), -6));
+    EXPECT_TRUE(equalByEpsilon(fixed.get_point(3, 0), -7));
+    EXPECT_EQ(fixed.to_matrix(), a);
+    EXPECT_EQ(Matrix4(), identity_matrix(4));
+}
+
+// Scenario: Converting a generic matrix of the wrong size throws
+// pMe
+TEST (TestFixedMatrices, ConvertingWrongSizeThrows) {
+    EXPECT_THROW(Matrix4(identity_matrix(3)), std::invalid_argument);
+}
+
+// Scenario: Fixed-size multiplication agrees with the generic matrix
+// pMe
+TEST (TestFixedMatrices, MultiplyingMatchesGeneric) {
+    std::vector<float> a_data = {1, 2, 3, 4,
+                                 5, 6, 7, 8,
+                                 9, 8, 7, 6,
+                                 5, 4, 3, 2};
+    std::vector<float> b_data = {-2, 1, 2,  3,
+                                  3, 2, 1, -1,
+                                  4, 3, 6,  5,
+                                  1, 2, 7,  8};
+    Matrix a(4, 4, a_data);
+    Matrix b(4, 4, b_data);
+    Tuple t(1, 2, 3, 1);
+
+    EXPECT_EQ(Matrix4(a) * Matrix4(b), a * b);
+    EXPECT_EQ(Matrix4(a) * t, a * t);
+    EXPECT_EQ(Matrix4(a) * 0.5, a * 0.5);
+    EXPECT_EQ(Matrix4(a).transpose(), a.transpose());
+}
+
+// Scenario: Fixed-size determinant, cofactors and inverse agree with the generic matrix
+// pMe
+TEST (TestFixedMatrices, InverseMatchesGeneric) {
+    std::vector<float> a_data = {-5,  2,  6, -8,
+                                  1, -5,  1,  8,
+                                  7,  7, -6, -7,
+                                  1, -3,  7,  4};
+    Matrix a(4, 4, a_data);
+    Matrix4 fixed = a;
+
+    EXPECT_TRUE(equalByEpsilon(fixed.determinant(), a.determinant()));
+    EXPECT_TRUE(equalByEpsilon(fixed.cofactor(2, 3), a.cofactor(2, 3)));
+    EXPECT_TRUE(equalByEpsilon(fixed.cofactor(3, 2), a.cofactor(3, 2)));
+    EXPECT_EQ(fixed.submatrix(2, 1), a.submatrix(2, 1));
+    EXPECT_EQ(fixed.inverse(), a.inverse());
+    EXPECT_EQ(fixed * fixed.inverse(), Matrix4());
+}
+
+// Scenario: The closed-form 4x4 inverse agrees with the cofactor expansion
+// pMe
+TEST (TestFixedMatrices, ClosedFormInverseMatchesCofactors) {
+    Matrix4 general = Matrix(4, 4, std::vector<float> { 8, -5,  9,  2,
+                                                        7,  5,  6,  1,
+                                                       -6,  0,  9,  6,
+                                                       -3,  0, -9, -4});
+    Matrix4 affine = Matrix(4, 4, std::vector<float> { 2,  1,  0,  3,
+                                                      -1,  4,  2, -5,
+                                                       0.5, 0,  3,  7,
+                                                       0,  0,  0,  1});
+    for (Matrix4 m : {general, affine}) {
+        float det = m.determinant();
+        float expected_det = 0;
+        for (unsigned int col = 0; col < 4; col++) {
+            expected_det += m.get_point(0, col) * m.cofactor(0, col);
+        };
+        EXPECT_TRUE(equalByEpsilon(det, expected_det));
+
+        Matrix4 inv = m.inverse();
+        for (unsigned int row = 0; row < 4; row++) {
+            for (unsigned int col = 0; col < 4; col++) {
+                EXPECT_TRUE(equalByEpsilon(inv.get_point(col, row), m.cofactor(row, col) / det));
+            };
+        };
+        EXPECT_EQ(m * inv, Matrix4());
+    };
+}
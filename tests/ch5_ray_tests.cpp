@@ -6,13 +6,16 @@
 #include "transform.h"
 #include "ray.h"
 #include "sphere.h"
+#include "plane.h"
 #include "intersection.h"
 #include "intersections.h"
+#include "arena.h"
 #include "gtest/gtest.h"
 
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <cstdint>
 
 
 // Scenario: Creating and querying a ray
@@ -262,3 +265,123 @@ TEST (TestRays, TestSphereEquality) {
         Sphere()
     );
 }
+
+// Scenario: Intersections spill from inline storage to the heap when full
+// pMe
+TEST (TestIntersections, SpillsBeyondInlineCapacity) {
+    Sphere s = Sphere();
+    Intersections xs;
+    EXPECT_EQ(xs.count, 0);
+    for (int i = 0; i < Intersections::inline_capacity; i++) {
+        xs.push_back(Intersection(10 - i, &s));
+    }
+    EXPECT_TRUE(xs.is_inline());
+    xs.push_back(Intersection(-1, &s));
+    xs.push_back(Intersection(0.5, &s));
+    EXPECT_FALSE(xs.is_inline());
+    EXPECT_EQ(xs.count, Intersections::inline_capacity + 2);
+    EXPECT_EQ(xs[0].t, 10);
+    EXPECT_EQ(xs[Intersections::inline_capacity + 1].t, 0.5);
+    EXPECT_EQ(xs.hit().t, 0.5);
+
+    xs.sort();
+    EXPECT_EQ(xs[0].t, -1);
+    EXPECT_EQ(xs[xs.count - 1].t, 10);
+
+    xs.clear();
+    EXPECT_EQ(xs.count, 0);
+    EXPECT_TRUE(xs.is_inline());
+}
+
+// Scenario: Copying and moving intersection lists
+// pMe
+TEST (TestIntersections, CopyAndMove) {
+    Sphere s = Sphere();
+    Intersections small = {Intersection(1, &s), Intersection(2, &s)};
+    Intersections large;
+    for (int i = 0; i < 20; i++) {
+        large.push_back(Intersection(i, &s));
+    }
+
+    Intersections small_copy = small;
+    Intersections large_copy = large;
+    EXPECT_EQ(small_copy.count, 2);
+    EXPECT_EQ(small_copy[1].t, 2);
+    EXPECT_EQ(large_copy.count, 20);
+    EXPECT_EQ(large_copy[19].t, 19);
+
+    Intersections small_moved = std::move(small);
+    Intersections large_moved = std::move(large);
+    EXPECT_EQ(small_moved.count, 2);
+    EXPECT_EQ(small_moved[0].t, 1);
+    EXPECT_EQ(large_moved.count, 20);
+    EXPECT_EQ(large_moved[19].t, 19);
+    EXPECT_EQ(small.count, 0);
+    EXPECT_EQ(large.count, 0);
+}
+
+// Scenario: Shapes append their intersections to a caller's list
+// pMe
+TEST (TestIntersections, ShapesAppendIntoList) {
+    Sphere s = Sphere(scaling_matrix(2, 2, 2));
+    Plane p = Plane();
+    Ray r = Ray(point(0, 5, -5), vector(0, -1, 1).normalize());
+    Intersections xs;
+    s.intersect_into(r, xs);
+    p.intersect_into(r, xs);
+    ASSERT_EQ(xs.count, 3);
+    EXPECT_EQ(xs[0].object, &s);
+    EXPECT_EQ(xs[1].object, &s);
+    EXPECT_EQ(xs[2].object, &p);
+    EXPECT_TRUE(equalByEpsilon(xs[0].t, s.intersect(r)[0].t));
+    EXPECT_TRUE(equalByEpsilon(xs[2].t, std::sqrt(50)));
+    EXPECT_TRUE(xs.is_inline());
+}
+
+// Scenario: An arena hands out aligned memory and reuses it after a reset
+// pMe
+TEST (TestArena, AllocateAndReset) {
+    Arena arena;
+    EXPECT_EQ(Arena::current(), (Arena *) NULL);
+    EXPECT_EQ(arena.get_blocks_allocated(), 0u);
+
+    char *c = static_cast<char *>(arena.allocate(1, 1));
+    Intersection *xs = arena.allocate_array<Intersection>(4);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(xs) % alignof(Intersection), 0u);
+    EXPECT_NE(static_cast<void *>(c), static_cast<void *>(xs));
+    EXPECT_EQ(arena.get_blocks_allocated(), 1u);
+
+    // Larger than a block: gets a block of its own
+    arena.allocate(Arena::block_size * 2);
+    EXPECT_EQ(arena.get_blocks_allocated(), 2u);
+
+    arena.reset();
+    EXPECT_EQ(arena.allocate(1, 1), static_cast<void *>(c));
+    arena.allocate(Arena::block_size * 2);
+    EXPECT_EQ(arena.get_blocks_allocated(), 2u);
+    EXPECT_EQ(arena.get_bytes_allocated(), 2 + 4 * sizeof(Intersection) + 4 * Arena::block_size);
+}
+
+// Scenario: Intersections spill into the current thread's arena
+// pMe
+TEST (TestIntersections, SpillsIntoCurrentArena) {
+    Sphere s = Sphere();
+    Arena arena;
+    {
+        Arena::Scope scope(arena);
+        EXPECT_EQ(Arena::current(), &arena);
+        Intersections xs;
+        for (int i = 0; i < 3 * Intersections::inline_capacity; i++) {
+            xs.push_back(Intersection(i, &s));
+        }
+        EXPECT_FALSE(xs.is_inline());
+        EXPECT_EQ(xs[3 * Intersections::inline_capacity - 1].t, 3 * Intersections::inline_capacity - 1);
+        EXPECT_GT(arena.get_bytes_allocated(), 0u);
+
+        Intersections moved = std::move(xs);
+        EXPECT_EQ(moved.count, 3 * Intersections::inline_capacity);
+        EXPECT_EQ(moved[0].t, 0);
+    }
+    EXPECT_EQ(Arena::current(), (Arena *) NULL);
+    EXPECT_EQ(arena.get_blocks_allocated(), 1u);
+}
@@ -258,7 +258,7 @@ TEST (TestCamera, ConstructingCamera) {
     EXPECT_EQ(c.hsize, 160);
     EXPECT_EQ(c.vsize, 120);
     EXPECT_TRUE(equalByEpsilon(c.field_of_view, M_PI / 2));
-    EXPECT_EQ(c.transform, Matrix(4));
+    EXPECT_EQ(c.get_transform(), Matrix(4));
 }
 
 // Scenario: The pixel size for a horizontal canvas
@@ -303,7 +303,7 @@ TEST (TestCamera, RayThruCornerOfCanvas) {
 // p103
 TEST (TestCamera, RayThruCameraTransformed) {
     Camera c(201, 101, M_PI / 2);
-    c.transform = rotation_y_matrix(M_PI / 4) * translation_matrix(0, -2, 5);
+    c.set_transform(rotation_y_matrix(M_PI / 4) * translation_matrix(0, -2, 5));
 
     Ray r = c.ray_for_pixel(100, 50);
 
@@ -321,7 +321,7 @@ TEST (TestCamera, RenderWorld) {
     Tuple to = point(0, 0, 0);
     Tuple up = vector(0, 1, 0);
 
-    c.transform = view_transform(from, to, up);
+    c.set_transform(view_transform(from, to, up));
 
     Canvas image = c.render(w);
 
@@ -338,7 +338,7 @@ TEST (TestCamera, RenderWorldDifferentWidths) {
     Tuple to = point(0, 0, 0);
     Tuple up = vector(0, 1, 0);
 
-    c.transform = view_transform(from, to, up);
+    c.set_transform(view_transform(from, to, up));
     
     Canvas image = c.render(w);
 
@@ -355,9 +355,410 @@ TEST (TestCamera, RenderWorldDifferentWidths2) {
     Tuple to = point(0, 0, 0);
     Tuple up = vector(0, 1, 0);
 
-    c.transform = view_transform(from, to, up);
+    c.set_transform(view_transform(from, to, up));
     
     Canvas image = c.render(w);
 
     EXPECT_EQ(image.pixel_at(10, 5), Color(0.38066, 0.47583, 0.2855));
 }
+
+// Scenario: Tiles cover every pixel of the canvas exactly once
+// pMe
+TEST (TestCamera, TilesCoverCanvas) {
+    Camera c(37, 21, M_PI / 2);
+    c.tile_size = 8;
+
+    std::vector<int> covered(37 * 21, 0);
+    for (Tile tile : c.tiles()) {
+        for (unsigned int y = tile.y0; y < tile.y1; y++) {
+            for (unsigned int x = tile.x0; x < tile.x1; x++) {
+                covered[y * 37 + x]++;
+            }
+        }
+    }
+
+    EXPECT_EQ(c.tiles().size(), 15);
+    for (int count : covered) {
+        EXPECT_EQ(count, 1);
+    }
+}
+
+// Scenario: Rendering on several threads matches a single-threaded render
+// pMe
+TEST (TestCamera, RenderWorldMultiThreaded) {
+    World w = default_world();
+    Camera c(33, 27, M_PI / 2);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+
+    Canvas expected = c.render(w);
+
+    c.threads = 4;
+    c.tile_size = 5;
+    Canvas actual = c.render(w);
+
+    for (unsigned int y = 0; y < 27; y++) {
+        for (unsigned int x = 0; x < 33; x++) {
+            EXPECT_EQ(actual.pixel_at(x, y), expected.pixel_at(x, y));
+        }
+    }
+}
+
+// Scenario: The closest hit matches the hit of the full intersection list
+// pMe
+TEST (TestWorld, ClosestHitMatchesIntersections) {
+    World w = default_world();
+    std::vector<Ray> rays = {
+        Ray(point(0, 0, -5), vector(0, 0, 1)),
+        Ray(point(0, 0, 0), vector(0, 0, 1)),
+        Ray(point(0, 0, 0.75), vector(0, 0, -1)),
+        Ray(point(0, 0, 5), vector(0, 0, 1)),
+        Ray(point(0, 0, -5), vector(0, 1, 0)),
+    };
+    for (int pass = 0; pass < 2; pass++) {
+        for (Ray r : rays) {
+            Intersection expected = w.intersect_world(r).hit();
+            Intersection actual = w.closest_hit(r);
+            EXPECT_EQ(actual.is_empty(), expected.is_empty());
+            if (!expected.is_empty()) {
+                EXPECT_EQ(actual.object, expected.object);
+                EXPECT_TRUE(equalByEpsilon(actual.t, expected.t));
+            }
+        }
+        w.build_bvh();
+    }
+}
+
+// Scenario: Packet closest hits match the closest hit of each ray
+// pMe
+TEST (TestWorld, PacketClosestHitsMatchSingleRays) {
+    World w = default_world();
+    Plane floor = Plane(translation_matrix(0, -1, 0));
+    w.objects.push_back(&floor);
+    std::vector<Ray> rays = {
+        Ray(point(0, 0, -5), vector(0, 0, 1)),
+        Ray(point(0, 0, 0), vector(0, 0, 1)),
+        Ray(point(0, 0, 0.75), vector(0, 0, -1)),
+        Ray(point(0, 0, 5), vector(0, 0, 1)),
+        Ray(point(0, 0, -5), vector(0, 1, 0)),
+        Ray(point(0, 0, -5), vector(0, -0.6, 0.8)),
+        Ray(point(3, 0, -5), vector(0, 0, 1)),
+    };
+    RayPacket packet;
+    for (unsigned int i = 0; i < rays.size(); i++) {
+        packet.set_ray(i, rays[i]);
+    }
+    // The last lane is left inactive
+    EXPECT_FALSE(packet.is_active(RayPacket::size - 1));
+    for (int pass = 0; pass < 2; pass++) {
+        PacketHits hits;
+        w.closest_hits(packet, hits);
+        for (unsigned int i = 0; i < rays.size(); i++) {
+            Intersection expected = w.closest_hit(rays[i]);
+            EXPECT_EQ(hits.get(i).is_empty(), expected.is_empty());
+            if (!expected.is_empty()) {
+                EXPECT_EQ(hits.object[i], expected.object);
+                EXPECT_TRUE(equalByEpsilon(hits.t[i], expected.t));
+            }
+        }
+        EXPECT_TRUE(hits.get(RayPacket::size - 1).is_empty());
+        w.build_bvh();
+    }
+}
+
+// Scenario: Camera packets hold the same rays as ray_for_pixel
+// pMe
+TEST (TestCamera, PacketForPixelsMatchesRayForPixel) {
+    Camera c = Camera(201, 101, M_PI / 2);
+    c.set_transform(rotation_y_matrix(M_PI / 4) * translation_matrix(0, -2, 5));
+    RayPacket packet = c.packet_for_pixels(195, 50, 6);
+    EXPECT_EQ(packet.active, 0x3Fu);
+    for (int i = 0; i < 6; i++) {
+        Ray expected = c.ray_for_pixel(195 + i, 50);
+        Ray actual = packet.get_ray(i);
+        EXPECT_EQ(actual.get_origin(), expected.get_origin());
+        // Bit for bit, including across the run boundary at x = 200
+        EXPECT_EQ(actual.get_direction().x, expected.get_direction().x);
+        EXPECT_EQ(actual.get_direction().y, expected.get_direction().y);
+        EXPECT_EQ(actual.get_direction().z, expected.get_direction().z);
+    }
+}
+
+// Scenario: Queries through the per-type shape arrays match the object list
+// pMe
+TEST (TestWorld, ShapeArraysMatchObjectList) {
+    World w = default_world();
+    Plane floor = Plane(translation_matrix(0, -1, 0));
+    w.objects.push_back(&floor);
+    std::vector<Ray> rays = {
+        Ray(point(0, 0, -5), vector(0, 0, 1)),
+        Ray(point(0, 0, 0), vector(0, 0, 1)),
+        Ray(point(0, 0, 0.75), vector(0, 0, -1)),
+        Ray(point(0, 0, 5), vector(0, 0, 1)),
+        Ray(point(0, 0, -5), vector(0, 1, 0)),
+        Ray(point(0, 0, -5), vector(0, -0.6, 0.8)),
+    };
+    std::vector<Intersection> expected;
+    std::vector<bool> expected_occluded;
+    for (Ray r : rays) {
+        expected.push_back(w.closest_hit(r));
+        expected_occluded.push_back(w.is_occluded(r, 4.5));
+    }
+
+    w.build_shape_arrays();
+    EXPECT_TRUE(w.has_shape_arrays());
+    EXPECT_EQ(w.shape_arrays.get_sphere_count(), 2);
+    EXPECT_EQ(w.shape_arrays.get_plane_count(), 1);
+    for (unsigned int i = 0; i < rays.size(); i++) {
+        Intersection actual = w.closest_hit(rays[i]);
+        EXPECT_EQ(actual.is_empty(), expected[i].is_empty());
+        if (!expected[i].is_empty()) {
+            EXPECT_EQ(actual.object, expected[i].object);
+            EXPECT_TRUE(equalByEpsilon(actual.t, expected[i].t));
+        }
+        EXPECT_EQ(w.is_occluded(rays[i], 4.5), expected_occluded[i]);
+    }
+
+    // Stale once the object list changes
+    w.objects.pop_back();
+    EXPECT_FALSE(w.has_shape_arrays());
+}
+
+// Scenario: Rendering a world through its shape arrays
+// pMe
+TEST (TestCamera, RenderWithShapeArrays) {
+    World w = default_world();
+    w.build_shape_arrays();
+    Camera c = Camera(11, 11, M_PI / 2);
+    Tuple from = point(0, 0, -5);
+    Tuple to = point(0, 0, 0);
+    Tuple up = vector(0, 1, 0);
+    c.set_transform(view_transform(from, to, up));
+    Canvas image = c.render(w);
+    EXPECT_EQ(image.pixel_at(5, 5), Color(0.38066, 0.47583, 0.2855));
+}
+
+// Scenario: Rendering reports per-frame arena usage
+// pMe
+TEST (TestCamera, RenderStats) {
+    World w = default_world();
+    Camera c = Camera(11, 11, M_PI / 2);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    c.threads = 2;
+    c.tile_size = 4;
+    RenderStats stats = {1, 1, 1, 1};
+    Canvas image = c.render(w, &stats);
+    EXPECT_EQ(image.pixel_at(5, 5), Color(0.38066, 0.47583, 0.2855));
+    // Every row of every tile is one packet, whose rays and hits are kept
+    // in the arena. No ray in the default world spills its intersections.
+    EXPECT_GT(stats.arena_bytes, 0u);
+    EXPECT_EQ(stats.arena_bytes, 3 * 11 * (sizeof(RayPacket) + sizeof(PacketHits)));
+    // A worker takes one block and reuses it for all of its tiles
+    EXPECT_GE(stats.arena_blocks, 1u);
+    EXPECT_LE(stats.arena_blocks, 2u);
+    EXPECT_EQ(stats.samples, 11u * 11u);
+
+    // render_tile works outside a render too, with an arena of its own
+    Canvas tile_image(11, 11);
+    c.render_tile(w, tile_image, Tile{3, 2, 9, 7});
+    EXPECT_EQ(tile_image.pixel_at(5, 5).red, image.pixel_at(5, 5).red);
+    EXPECT_EQ(tile_image.pixel_at(8, 6).green, image.pixel_at(8, 6).green);
+}
+
+// Scenario: The camera caches its inverse and steps rays across the canvas
+// pMe
+TEST (TestCamera, IncrementalRaysMatchInverseTransform) {
+    Camera c = Camera(201, 101, M_PI / 3);
+    Matrix4 transform = view_transform(point(1, 2, -5), point(0, 1, 0), vector(0, 1, 0));
+    c.set_transform(transform);
+    EXPECT_EQ(c.get_transform(), transform);
+    EXPECT_EQ(c.get_inverse(), transform.inverse());
+
+    int pixels[][2] = {{0, 0}, {200, 0}, {0, 100}, {100, 50}, {200, 100}, {37, 81}};
+    for (auto &p : pixels) {
+        float world_x = c.half_width - (p[0] + 0.5f) * c.pixel_size;
+        float world_y = c.half_height - (p[1] + 0.5f) * c.pixel_size;
+        Tuple origin = transform.inverse() * point(0, 0, 0);
+        Tuple pixel = transform.inverse() * point(world_x, world_y, -1);
+        Ray r = c.ray_for_pixel(p[0], p[1]);
+        EXPECT_EQ(r.get_origin(), origin);
+        EXPECT_EQ(r.get_direction(), (pixel - origin).normalize());
+    }
+
+    // The last lane of a packet is stepped from the first
+    RayPacket packet = c.packet_for_pixels(192, 100, RayPacket::size);
+    EXPECT_EQ(packet.get_ray(RayPacket::size - 1).get_direction(), c.ray_for_pixel(192 + RayPacket::size - 1, 100).get_direction());
+}
+
+// Scenario: A sample at a pixel's centre is the pixel's ray
+// pMe
+TEST (TestCamera, RayForSampleAtPixelCentre) {
+    Camera c = Camera(201, 101, M_PI / 2);
+    c.set_transform(rotation_y_matrix(M_PI / 4) * translation_matrix(0, -2, 5));
+    Ray r = c.ray_for_sample(100.5, 50.5);
+    EXPECT_EQ(r.get_origin(), c.ray_for_pixel(100, 50).get_origin());
+    EXPECT_EQ(r.get_direction(), c.ray_for_pixel(100, 50).get_direction());
+}
+
+// Scenario: Adaptive anti-aliasing only supersamples high-contrast pixels
+// pMe
+TEST (TestCamera, AdaptiveSupersampling) {
+    World w = default_world();
+    Camera c = Camera(40, 30, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    RenderStats plain_stats;
+    Canvas plain = c.render(w, &plain_stats);
+    EXPECT_EQ(plain_stats.samples, 40u * 30u);
+    EXPECT_EQ(plain_stats.supersampled_pixels, 0u);
+
+    c.supersampling = 4;
+    c.aa_threshold = 0.01;
+    RenderStats stats;
+    Canvas image = c.render(w, &stats);
+    EXPECT_GT(stats.supersampled_pixels, 0u);
+    EXPECT_LT(stats.supersampled_pixels, 40u * 30u / 2);
+    EXPECT_EQ(stats.samples, 40u * 30u + 16 * stats.supersampled_pixels);
+
+    // Corners only see the background, and the centre is smoothly shaded
+    EXPECT_EQ(image.pixel_at(0, 0), plain.pixel_at(0, 0));
+    EXPECT_EQ(image.pixel_at(20, 15), plain.pixel_at(20, 15));
+    unsigned int changed = 0;
+    for (unsigned int y = 0; y < 30; y++) {
+        for (unsigned int x = 0; x < 40; x++) {
+            if (!(image.pixel_at(x, y) == plain.pixel_at(x, y))) {
+                changed++;
+            }
+        }
+    }
+    EXPECT_GT(changed, 0u);
+    EXPECT_LE(changed, stats.supersampled_pixels);
+
+    // Jitter is seeded by pixel, so threading doesn't change the image
+    c.threads = 3;
+    c.tile_size = 7;
+    Canvas threaded = c.render(w);
+    for (unsigned int y = 0; y < 30; y++) {
+        for (unsigned int x = 0; x < 40; x++) {
+            EXPECT_EQ(threaded.pixel_at(x, y), image.pixel_at(x, y));
+        }
+    }
+}
+
+// Scenario: Progressive passes refine the image until it matches a full render
+// pMe
+TEST (TestCamera, ProgressiveRender) {
+    World w = default_world();
+    Camera c = Camera(41, 27, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    c.tile_size = 12;
+    Canvas full = c.render(w);
+
+    std::vector<unsigned int> passes;
+    std::vector<Color> centre;
+    RenderStats stats;
+    Canvas image = c.render_progressive(w, [&](const Canvas &partial, unsigned int pass) {
+        passes.push_back(pass);
+        centre.push_back(partial.pixel_at(21, 14));
+        if (pass == 0) {
+            // One ray per 8x8 block, filling the block
+            EXPECT_EQ(partial.pixel_at(23, 15), partial.pixel_at(16, 8));
+        }
+        return true;
+    }, std::chrono::steady_clock::time_point::max(), &stats);
+
+    EXPECT_EQ(passes, std::vector<unsigned int>({0, 1, 2, 3}));
+    EXPECT_EQ(centre.back(), full.pixel_at(21, 14));
+    // Every pixel is traced exactly once over the passes
+    EXPECT_EQ(stats.samples, 41u * 27u);
+    auto expect_identical = [](const Canvas &a, const Canvas &b) {
+        for (unsigned int y = 0; y < a.get_height(); y++) {
+            for (unsigned int x = 0; x < a.get_width(); x++) {
+                EXPECT_EQ(a.pixel_at(x, y).red, b.pixel_at(x, y).red);
+                EXPECT_EQ(a.pixel_at(x, y).green, b.pixel_at(x, y).green);
+                EXPECT_EQ(a.pixel_at(x, y).blue, b.pixel_at(x, y).blue);
+            }
+        }
+    };
+    expect_identical(image, full);
+
+    c.supersampling = 3;
+    c.threads = 2;
+    passes.clear();
+    expect_identical(c.render_progressive(w, [&](const Canvas &, unsigned int pass) {
+        passes.push_back(pass);
+        return true;
+    }), c.render(w));
+    EXPECT_EQ(passes, std::vector<unsigned int>({0, 1, 2, 3, 4}));
+}
+
+// Scenario: Progressive rendering stops when asked or out of time
+// pMe
+TEST (TestCamera, ProgressiveRenderStops) {
+    World w = default_world();
+    Camera c = Camera(41, 27, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    c.threads = 2;
+    unsigned int calls = 0;
+    auto stop_after_first = [&](const Canvas &, unsigned int) {
+        calls++;
+        return false;
+    };
+
+    RenderStats stats;
+    Canvas coarse = c.render_progressive(w, stop_after_first, std::chrono::steady_clock::time_point::max(), &stats);
+    EXPECT_EQ(calls, 1u);
+    EXPECT_EQ(stats.samples, 6u * 4u);
+    EXPECT_EQ(coarse.pixel_at(40, 26), coarse.pixel_at(40, 24));
+
+    // A deadline that has already passed leaves every tile untouched
+    calls = 0;
+    Canvas late = c.render_progressive(w, [&](const Canvas &, unsigned int) {
+        calls++;
+        return true;
+    }, std::chrono::steady_clock::now(), &stats);
+    EXPECT_EQ(calls, 1u);
+    EXPECT_EQ(stats.samples, 0u);
+    EXPECT_EQ(late.pixel_at(20, 13), Color(0, 0, 0));
+}
+
+// Scenario: Rendering regions gives the same pixels as a full render
+// pMe
+TEST (TestCamera, RenderRegionsMatchFullRender) {
+    World w = default_world();
+    Camera c = Camera(40, 30, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    c.tile_size = 8;
+    for (unsigned int supersampling : {1u, 3u}) {
+        c.supersampling = supersampling;
+        c.threads = 1;
+        Canvas full = c.render(w);
+
+        c.threads = 2;
+        std::vector<Tile> regions = {{0, 0, 40, 10}, {0, 10, 17, 30}, {17, 10, 40, 30}, {12, 5, 13, 25}};
+        RenderStats stats;
+        std::vector<Canvas> parts = c.render_regions(w, regions, &stats);
+        ASSERT_EQ(parts.size(), regions.size());
+        EXPECT_EQ(parts[3].get_width(), 1);
+        EXPECT_EQ(parts[3].get_height(), 20);
+        if (supersampling == 1) {
+            EXPECT_EQ(stats.samples, 40u * 30u + 20u);
+        }
+
+        Canvas composite(40, 30);
+        for (unsigned int i = 0; i < 3; i++) {
+            composite.paste(parts[i], regions[i].x0, regions[i].y0);
+        }
+        for (unsigned int y = 0; y < 30; y++) {
+            for (unsigned int x = 0; x < 40; x++) {
+                EXPECT_EQ(composite.pixel_at(x, y), full.pixel_at(x, y));
+            }
+        }
+        Canvas strip = c.render_region(w, regions[3]);
+        for (unsigned int y = 0; y < 20; y++) {
+            EXPECT_EQ(strip.pixel_at(0, y), full.pixel_at(12, 5 + y));
+            EXPECT_EQ(parts[3].pixel_at(0, y), full.pixel_at(12, 5 + y));
+        }
+    }
+
+    EXPECT_THROW(c.render_region(w, Tile{10, 10, 10, 20}), std::invalid_argument);
+    EXPECT_THROW(c.render_region(w, Tile{30, 0, 41, 10}), std::invalid_argument);
+}
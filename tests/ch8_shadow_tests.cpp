@@ -99,4 +99,85 @@ TEST (TestShadows, HitOffsetAtPoint) {
 
     EXPECT_TRUE(comps.over_point.z < -EPSILON / 2);
     EXPECT_TRUE(comps.point.z > comps.over_point.z);
-}
\ No newline at end of file
+}
+
+// Scenario: A shape only occludes within the given distance
+// pMe
+TEST (TestShadows, ShapeOccludesWithinDistance) {
+    Sphere s;
+    s.set_transform(translation_matrix(0, 0, 5));
+    Plane p;
+    p.set_transform(translation_matrix(0, -1, 0));
+    Ray r(point(0, 0, 0), vector(0, 0, 1));
+    Ray down(point(0, 0, 0), vector(0, -1, 0));
+
+    EXPECT_TRUE(s.occludes(r, 10));
+    EXPECT_FALSE(s.occludes(r, 3));
+    EXPECT_FALSE(s.occludes(Ray(point(0, 0, 10), vector(0, 0, 1)), 10));
+    EXPECT_TRUE(p.occludes(down, 2));
+    EXPECT_FALSE(p.occludes(down, 0.5));
+    EXPECT_FALSE(p.occludes(r, 100));
+}
+
+// Scenario: Shadow tests agree with and without a BVH
+// pMe
+TEST (TestShadows, ShadowsMatchWithBVH) {
+    World w = default_world();
+    std::vector<Tuple> points = {
+        point(0, 10, 0),
+        point(10, -10, 10),
+        point(-20, 20, -20),
+        point(-2, 2, -2),
+    };
+    std::vector<bool> expected;
+    for (Tuple p : points) {
+        expected.push_back(w.is_shadowed(p));
+    }
+
+    w.build_bvh();
+    for (unsigned int i = 0; i < points.size(); i++) {
+        EXPECT_EQ(w.is_shadowed(points[i]), expected[i]);
+    }
+}
+
+// Scenario: shade_hit() sums the light from every light source
+// pMe
+TEST (TestShadows, ShadeHitSumsLights) {
+    World w = default_world();
+    Ray r(point(0, 0, -5), vector(0, 0, 1));
+    Intersection i(4, w.objects[0]);
+    Computation comps = i.prepare_computations(r);
+    Color one = w.shade_hit(comps);
+
+    w.lights.push_back(w.lights[0]);
+    EXPECT_EQ(w.shade_hit(comps), one * 2);
+
+    // A light behind the surface only adds its ambient light
+    PointLight behind = PointLight(point(0, 0, 10), Color(1, 1, 1));
+    w.lights = {w.lights[0], behind};
+    Color ambient = Material(Color(0.8, 1.0, 0.6), 0.1, 0.7, 0.2, 200.0).color * 0.1;
+    EXPECT_EQ(w.shade_hit(comps), one + ambient);
+    EXPECT_TRUE(w.is_shadowed(comps.over_point, behind));
+    EXPECT_FALSE(w.is_shadowed(comps.over_point, w.lights[0]));
+}
+
+// Scenario: Lights that can't contribute enough are culled
+// pMe
+TEST (TestShadows, ShadeHitCullsDimLights) {
+    Sphere s;
+    PointLight bright = PointLight(point(0, 0, -10), Color(1, 1, 1));
+    PointLight dim = PointLight(point(0, 0, -10), Color(0.01, 0.01, 0.01));
+    World w(std::vector<Shape *>{&s}, std::vector<PointLight>{bright, dim});
+    Ray r(point(0, 0, -5), vector(0, 0, 1));
+    Intersection i(4, &s);
+    Computation comps = i.prepare_computations(r);
+    const Material &m = s.get_material();
+
+    Color lit = m.lighting(&s, bright, comps.over_point, comps.eyev, comps.normalv, false);
+    Color dim_lit = m.lighting(&s, dim, comps.over_point, comps.eyev, comps.normalv, false);
+    Color dim_ambient = m.lighting(&s, dim, comps.over_point, comps.eyev, comps.normalv, true);
+    EXPECT_EQ(w.shade_hit(comps), lit + dim_lit);
+
+    w.light_cutoff = 0.05;
+    EXPECT_EQ(w.shade_hit(comps), lit + dim_ambient);
+}
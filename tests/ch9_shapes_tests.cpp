@@ -12,15 +12,15 @@
 class TestShape : public Shape {
     public:
         // default ray
-        Ray saved_ray = Ray(
+        mutable Ray saved_ray = Ray(
             point(0, 0, 0),
             vector(1, 0, 0)
         );
-        Intersections local_intersect(Ray r) {
+        Intersections local_intersect(const Ray &r) const {
             this->saved_ray = r;
             return Intersections();
         };
-        Tuple local_normal_at(Tuple p) {
+        Tuple local_normal_at(const Tuple &p) const {
             return vector(p.x, p.y, p.z);
         };
 };
@@ -43,6 +43,16 @@ TEST (TestAbstractShape, AssignedTransform) {
     EXPECT_EQ(s.get_transform(), translation_matrix(2, 3, 4));
 }
 
+// Scenario: Assigning a transformation caches its inverse and inverse transpose
+// pMe
+TEST (TestAbstractShape, AssignedTransformCachesInverse) {
+    TestShape s = TestShape();
+    Matrix t = scaling_matrix(1, 0.5, 1) * rotation_z_matrix(M_PI / 5);
+    s.set_transform(t);
+    EXPECT_EQ(s.get_inverse_transform(), t.inverse());
+    EXPECT_EQ(s.get_inverse_transpose(), t.inverse().transpose());
+}
+
 
 // Scenario: The default material
 // p119
@@ -0,0 +1,95 @@
+#include "ray_tracer.h"
+#include "gtest/gtest.h"
+#include <math.h>
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+
+#include <unistd.h>
+#include <sys/mman.h>
+
+
+// Rendering across processes
+static Camera test_camera() {
+    Camera c = Camera(50, 30, M_PI / 3);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    return c;
+}
+
+static void expect_same_image(const Canvas &actual, const Canvas &expected) {
+    ASSERT_EQ(actual.get_width(), expected.get_width());
+    ASSERT_EQ(actual.get_height(), expected.get_height());
+    for (unsigned int y = 0; y < expected.get_height(); y++) {
+        for (unsigned int x = 0; x < expected.get_width(); x++) {
+            EXPECT_EQ(actual.pixel_at(x, y), expected.pixel_at(x, y));
+        }
+    }
+}
+
+// A sphere that kills the worker process tracing it, as long as crashes
+// (shared between processes) is above zero
+class CrashingSphere : public Sphere {
+    public:
+        pid_t coordinator;
+        std::atomic<int> *crashes;
+        void local_nearest_hits(const RayPacket &r, PacketHits &hits) const override {
+            if (getpid() != coordinator && (*crashes).fetch_sub(1) > 0) {
+                _exit(3);
+            }
+            Sphere::local_nearest_hits(r, hits);
+        };
+};
+
+// Scenario: A frame rendered by worker processes matches a local render
+// pMe
+TEST (TestDistributedRender, MatchesLocalRender) {
+    World w = default_world();
+    Camera c = test_camera();
+    Canvas expected = c.render(w);
+
+    DistributedStats stats;
+    Canvas image = render_distributed(w, c, 3, 16, &stats);
+    EXPECT_EQ(stats.jobs, 4u * 2u);
+    EXPECT_EQ(stats.failed_workers, 0u);
+    EXPECT_EQ(stats.reassigned_jobs, 0u);
+    expect_same_image(image, expected);
+
+    // Anti-aliasing looks past the edge of each job
+    c.supersampling = 3;
+    expect_same_image(render_distributed(w, c, 2, 7), c.render(w));
+}
+
+// Scenario: Jobs of a crashed worker are given to the others
+// pMe
+TEST (TestDistributedRender, ReassignsJobsOfCrashedWorkers) {
+    std::atomic<int> *crashes = static_cast<std::atomic<int> *>(mmap(
+        NULL, sizeof(std::atomic<int>), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0
+    ));
+    ASSERT_NE(crashes, MAP_FAILED);
+    new (crashes) std::atomic<int>(1);
+
+    World w = default_world();
+    CrashingSphere s;
+    s.coordinator = getpid();
+    s.crashes = crashes;
+    s.set_transform(translation_matrix(2.5, 0, 0));
+    w.objects.push_back(&s);
+    Camera c = test_camera();
+    (*crashes) = -1000000;
+    Canvas expected = c.render(w);
+
+    (*crashes) = 1;
+    DistributedStats stats;
+    Canvas image = render_distributed(w, c, 3, 16, &stats);
+    EXPECT_EQ(stats.failed_workers, 1u);
+    EXPECT_EQ(stats.reassigned_jobs, 1u);
+    expect_same_image(image, expected);
+
+    // With every worker crashing the frame can't be finished
+    (*crashes) = 1000000;
+    EXPECT_THROW(render_distributed(w, c, 2, 16), std::runtime_error);
+
+    munmap(crashes, sizeof(std::atomic<int>));
+}
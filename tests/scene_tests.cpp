@@ -0,0 +1,381 @@
+#include "ray_tracer.h"
+#include "gtest/gtest.h"
+#include <math.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <stdexcept>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+
+// Scene files
+const std::string camera_and_light =
+    "- add: camera\n"
+    "  width: 100\n"
+    "  height: 50\n"
+    "  field-of-view: 0.785\n"
+    "  from: [0, 1.5, -5]\n"
+    "  to: [0, 1, 0]\n"
+    "  up: [0, 1, 0]\n"
+    "- add: light\n"
+    "  at: [-10, 10, -10]\n"
+    "  intensity: [1, 1, 1]\n";
+
+// Scenario: Reading the camera and light
+TEST (TestScene, CameraAndLight) {
+    Scene scene = parse_scene(camera_and_light);
+
+    EXPECT_EQ(scene.camera.hsize, 100);
+    EXPECT_EQ(scene.camera.vsize, 50);
+    EXPECT_FLOAT_EQ(scene.camera.field_of_view, 0.785);
+    EXPECT_EQ(scene.camera.get_transform(), Matrix4(view_transform(point(0, 1.5, -5), point(0, 1, 0), vector(0, 1, 0))));
+    ASSERT_EQ(scene.world.lights.size(), 1);
+    EXPECT_EQ(scene.world.lights[0].get_position(), point(-10, 10, -10));
+    EXPECT_EQ(scene.world.lights[0].get_intensity(), Color(1, 1, 1));
+    EXPECT_TRUE(scene.world.objects.empty());
+}
+
+// Scenario: Shapes with materials and transforms applied in order
+TEST (TestScene, ShapesMaterialsAndTransforms) {
+    Scene scene = parse_scene(camera_and_light +
+        "# The floor\n"
+        "- add: plane\n"
+        "  material:\n"
+        "    color: [1, 0.9, 0.9]\n"
+        "    specular: 0\n"
+        "    pattern:\n"
+        "      type: stripes\n"
+        "      colors: [[1, 1, 1], [0, 0, 0]]\n"
+        "      transform:\n"
+        "        - [scale, 0.5, 0.5, 0.5]\n"
+        "- add: sphere\n"
+        "  transform:\n"
+        "  - [scale, 2, 2, 2]\n"
+        "  - [translate, 1, 0, 0]   # after the scale\n"
+        "  material:\n"
+        "    ambient: 0.2\n"
+    );
+
+    ASSERT_EQ(scene.world.objects.size(), 2);
+    const Shape &floor = *scene.world.objects[0];
+    EXPECT_EQ(floor.get_material().color, Color(1, 0.9, 0.9));
+    EXPECT_FLOAT_EQ(floor.get_material().specular, 0);
+    ASSERT_NE(floor.get_material().pattern, nullptr);
+    EXPECT_EQ((*floor.get_material().pattern).stripe_at_object(&floor, point(0.75, 0, 0)), Color(0, 0, 0));
+    EXPECT_EQ(floor.get_transform(), Matrix4());
+
+    const Shape &sphere = *scene.world.objects[1];
+    EXPECT_EQ(sphere.get_transform(), Matrix4(translation_matrix(1, 0, 0) * scaling_matrix(2, 2, 2)));
+    EXPECT_FLOAT_EQ(sphere.get_material().ambient, 0.2);
+    EXPECT_FLOAT_EQ(sphere.get_material().diffuse, Material().diffuse);
+}
+
+// Scenario: Defined materials and transforms, and extending them
+TEST (TestScene, Definitions) {
+    Scene scene = parse_scene(camera_and_light +
+        "- define: white\n"
+        "  value:\n"
+        "    color: [1, 1, 1]\n"
+        "    diffuse: 0.7\n"
+        "- define: red\n"
+        "  extend: white\n"
+        "  value:\n"
+        "    color: [1, 0, 0]\n"
+        "- define: small\n"
+        "  value:\n"
+        "    - [scale, 0.5, 0.5, 0.5]\n"
+        "- add: sphere\n"
+        "  material: red\n"
+        "  transform:\n"
+        "    - small\n"
+        "    - [translate, 0, 1, 0]\n"
+    );
+
+    const Shape &sphere = *scene.world.objects[0];
+    EXPECT_EQ(sphere.get_material().color, Color(1, 0, 0));
+    EXPECT_FLOAT_EQ(sphere.get_material().diffuse, 0.7);
+    EXPECT_EQ(sphere.get_transform(), Matrix4(translation_matrix(0, 1, 0) * scaling_matrix(0.5, 0.5, 0.5)));
+}
+
+// Scenario: A loaded scene renders like the same scene built in code
+TEST (TestScene, RendersLikeCode) {
+    Scene scene = parse_scene(
+        "- add: camera\n"
+        "  width: 11\n"
+        "  height: 11\n"
+        "  field-of-view: 1.5707963\n"
+        "  from: [0, 0, -5]\n"
+        "  to: [0, 0, 0]\n"
+        "- add: light\n"
+        "  at: [-10, 10, -10]\n"
+        "  intensity: [1, 1, 1]\n"
+        "- add: sphere\n"
+        "  material:\n"
+        "    color: [0.8, 1.0, 0.6]\n"
+        "    diffuse: 0.7\n"
+        "    specular: 0.2\n"
+        "- add: sphere\n"
+        "  transform:\n"
+        "    - [scale, 0.5, 0.5, 0.5]\n"
+    );
+
+    World w = default_world();
+    Camera c = Camera(11, 11, M_PI / 2);
+    c.set_transform(view_transform(point(0, 0, -5), point(0, 0, 0), vector(0, 1, 0)));
+    EXPECT_EQ(scene.camera.render(scene.world).pixel_at(5, 5), c.render(w).pixel_at(5, 5));
+}
+
+// Scenario: Malformed scenes report the offending line
+TEST (TestScene, Errors) {
+    std::vector<std::pair<std::string, std::string>> cases = {
+        {camera_and_light + "- add: cube\n", "line 11: unknown item 'cube'"},
+        {camera_and_light + "- add: sphere\n  colour: [1, 0, 0]\n", "line 12: unknown key 'colour'"},
+        {camera_and_light + "- add: sphere\n  transform:\n    - [scale, 1, 2]\n", "line 13: scale takes 3 values"},
+        {camera_and_light + "- add: sphere\n  material: missing\n", "line 12: no material named 'missing'"},
+        {camera_and_light + "- add: light\n  at: [1, 2, x]\n  intensity: [1, 1, 1]\n", "line 12: expected a number, got 'x'"},
+        {camera_and_light + "- add: light\n  at: [1, 2, 3\n", "line 12: expected ',' or ']'"},
+        {camera_and_light + "- add: sphere\n      material: missing\n", "line 12: unexpected indentation"},
+        {"- add: light\n  at: [1, 2, 3]\n  intensity: [1, 1, 1]\n", "no camera"},
+    };
+    for (const std::pair<std::string, std::string> &c : cases) {
+        try {
+            parse_scene(c.first);
+            ADD_FAILURE() << "No error for: " << c.second;
+        } catch (const std::invalid_argument &e) {
+            EXPECT_NE(std::string(e.what()).find(c.second), std::string::npos) << e.what();
+        }
+    }
+}
+
+// Scenario: Loading a missing scene file
+TEST (TestScene, MissingFile) {
+    EXPECT_THROW(load_scene("no_such_scene.yml"), std::runtime_error);
+}
+
+// Compiled scene cache
+// Scenario: A cached scene loads with the same camera, shapes and BVH
+TEST (TestSceneCache, RoundTrip) {
+    Scene scene = parse_scene(camera_and_light +
+        "- add: plane\n"
+        "  material:\n"
+        "    pattern:\n"
+        "      type: stripes\n"
+        "      colors: [[1, 1, 1], [0, 0, 0]]\n"
+        "      transform:\n"
+        "        - [rotate-y, 0.5]\n"
+        "- add: sphere\n"
+        "  material:\n"
+        "    color: [0.8, 1.0, 0.6]\n"
+        "    diffuse: 0.7\n"
+        "- add: sphere\n"
+        "  transform:\n"
+        "    - [scale, 0.5, 0.5, 0.5]\n"
+        "    - [translate, 1, 1, 0]\n"
+    );
+    scene.world.light_cutoff = 0.25;
+    write_scene_cache(scene.world, scene.camera, "scene_cache_test.rtscene");
+    EXPECT_TRUE(is_scene_cache("scene_cache_test.rtscene"));
+    Scene cached = load_scene_cache("scene_cache_test.rtscene");
+    EXPECT_FLOAT_EQ(cached.world.light_cutoff, 0.25);
+
+    EXPECT_EQ(cached.camera.hsize, scene.camera.hsize);
+    EXPECT_EQ(cached.camera.vsize, scene.camera.vsize);
+    EXPECT_EQ(cached.camera.get_transform(), scene.camera.get_transform());
+    ASSERT_EQ(cached.world.objects.size(), 3);
+    ASSERT_EQ(cached.world.lights.size(), 1);
+    EXPECT_EQ(cached.world.lights[0].get_position(), scene.world.lights[0].get_position());
+    EXPECT_TRUE(cached.world.has_bvh());
+    EXPECT_EQ(cached.world.bvh.get_node_count(), 3);
+    for (int i = 0; i < 3; i++) {
+        const Shape &expected = *scene.world.objects[i];
+        const Shape &actual = *cached.world.objects[i];
+        EXPECT_EQ(actual.get_transform(), expected.get_transform());
+        EXPECT_EQ(actual.get_inverse_transform(), expected.get_inverse_transform());
+        EXPECT_EQ(actual.get_material().color, expected.get_material().color);
+        EXPECT_FLOAT_EQ(actual.get_material().diffuse, expected.get_material().diffuse);
+        EXPECT_EQ(actual.get_material().pattern == NULL, expected.get_material().pattern == NULL);
+    }
+    EXPECT_NE(dynamic_cast<const Plane *>(cached.world.objects[0]), nullptr);
+    EXPECT_EQ(
+        (*cached.world.objects[0]->get_material().pattern).get_inverse_transform(),
+        Matrix4(rotation_y_matrix(0.5)).inverse()
+    );
+
+    Canvas expected = scene.camera.render(scene.world);
+    Canvas actual = cached.camera.render(cached.world);
+    for (int y = 0; y < 50; y += 7) {
+        for (int x = 0; x < 100; x += 7) {
+            EXPECT_EQ(actual.pixel_at(x, y), expected.pixel_at(x, y));
+        }
+    }
+    std::remove("scene_cache_test.rtscene");
+}
+
+// Scenario: Files that aren't scene caches, or have another version, are rejected
+TEST (TestSceneCache, RejectsOtherFiles) {
+    std::FILE * file = std::fopen("not_a_cache.rtscene", "wb");
+    std::fputs("- add: camera\n", file);
+    std::fclose(file);
+    EXPECT_FALSE(is_scene_cache("not_a_cache.rtscene"));
+    EXPECT_THROW(load_scene_cache("not_a_cache.rtscene"), std::runtime_error);
+
+    file = std::fopen("not_a_cache.rtscene", "wb");
+    std::fwrite("RTCSCENE", 1, 8, file);
+    unsigned int version = scene_cache_version + 1;
+    std::fwrite(&version, sizeof(version), 1, file);
+    std::fclose(file);
+    EXPECT_TRUE(is_scene_cache("not_a_cache.rtscene"));
+    EXPECT_THROW(load_scene_cache("not_a_cache.rtscene"), std::runtime_error);
+    std::remove("not_a_cache.rtscene");
+
+    EXPECT_THROW(load_scene_cache("no_such_cache.rtscene"), std::runtime_error);
+}
+
+// Scenario: A cache whose BVH nodes don't form a shallow enough tree is rejected
+// pMe
+TEST (TestSceneCache, RejectsMalformedBVH) {
+    std::string text = camera_and_light;
+    for (int i = 0; i < 50; i++) {
+        text += "- add: sphere\n  transform:\n    - [translate, " + std::to_string(3 * i) + ", 0, 0]\n";
+    }
+    Scene scene = parse_scene(text);
+    write_scene_cache(scene.world, scene.camera, "deep_cache.rtscene");
+    std::FILE * file = std::fopen("deep_cache.rtscene", "rb");
+    std::vector<char> bytes(1 << 16);
+    bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+    std::fclose(file);
+
+    // Layout from scene_cache.cpp: header fields are 4 bytes after the
+    // 8 byte magic, shape records 41 fields, lights 6 and nodes 9
+    uint32_t counts[6];
+    std::memcpy(counts, bytes.data() + 12, sizeof(counts));
+    uint32_t pattern_count = counts[0], shape_count = counts[1], light_count = counts[2], node_count = counts[3];
+    ASSERT_EQ(pattern_count, 0u);
+    ASSERT_EQ(shape_count, 50u);
+    ASSERT_EQ(node_count, 99u);
+    std::size_t nodes_at = (8 + 8 * 4 + 19 * 4) + shape_count * 41 * 4 + light_count * 6 * 4;
+    auto write_nodes = [&](const std::vector<std::array<uint32_t, 3>> &nodes) {
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            float box[6] = {-1000, -1000, -1000, 1000, 1000, 1000};
+            std::memcpy(bytes.data() + nodes_at + i * 36, box, sizeof(box));
+            std::memcpy(bytes.data() + nodes_at + i * 36 + 24, nodes[i].data(), 12);
+        }
+        std::FILE * out = std::fopen("deep_cache.rtscene", "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), out);
+        std::fclose(out);
+    };
+
+    // A chain: each interior node's first child is a leaf and its second
+    // the next interior node, 49 levels deep
+    std::vector<std::array<uint32_t, 3>> chain;
+    for (uint32_t i = 0; i < 49; i++) {
+        chain.push_back({2 * i + 2, 0, 0});
+        chain.push_back({i, 1, 0});
+    }
+    chain.push_back({49, 1, 0});
+    write_nodes(chain);
+    EXPECT_THROW(load_scene_cache("deep_cache.rtscene"), std::runtime_error);
+
+    // Exactly 48 levels fits the traversal stack: the root's first child
+    // holds two leaves, leaving one interior node fewer for the chain
+    std::vector<std::array<uint32_t, 3>> shallow = {{4, 0, 0}, {3, 0, 0}, {0, 1, 0}, {1, 1, 0}};
+    for (uint32_t k = 0; k < 47; k++) {
+        shallow.push_back({6 + 2 * k, 0, 0});
+        shallow.push_back({2 + k, 1, 0});
+    }
+    shallow.push_back({49, 1, 0});
+    write_nodes(shallow);
+    EXPECT_TRUE(load_scene_cache("deep_cache.rtscene").world.has_bvh());
+
+    // A node pointing back at an ancestor
+    std::vector<std::array<uint32_t, 3>> cycle = chain;
+    cycle[2] = {0, 0, 0};
+    write_nodes(cycle);
+    EXPECT_THROW(load_scene_cache("deep_cache.rtscene"), std::runtime_error);
+
+    // Two leaves holding the same shape, so another is in none
+    std::vector<std::array<uint32_t, 3>> overlap = shallow;
+    overlap[2] = {1, 1, 0};
+    write_nodes(overlap);
+    EXPECT_THROW(load_scene_cache("deep_cache.rtscene"), std::runtime_error);
+    std::remove("deep_cache.rtscene");
+}
+
+// Writes a small cache and returns its bytes, for the tests below to patch
+static std::vector<char> small_cache_bytes(const std::string &filename) {
+    Scene scene = parse_scene(camera_and_light +
+        "- add: sphere\n"
+        "- add: sphere\n"
+        "  transform:\n"
+        "    - [translate, 3, 0, 0]\n"
+        "- add: plane\n"
+    );
+    write_scene_cache(scene.world, scene.camera, filename);
+    std::FILE * file = std::fopen(filename.c_str(), "rb");
+    std::vector<char> bytes(1 << 16);
+    bytes.resize(std::fread(bytes.data(), 1, bytes.size(), file));
+    std::fclose(file);
+    return bytes;
+}
+
+static void write_cache_bytes(const std::vector<char> &bytes, const std::string &filename) {
+    std::FILE * file = std::fopen(filename.c_str(), "wb");
+    std::fwrite(bytes.data(), 1, bytes.size(), file);
+    std::fclose(file);
+}
+
+// Scenario: A cache with an empty or implausibly large frame is rejected
+// pMe
+TEST (TestSceneCache, RejectsBadFrameSize) {
+    std::vector<char> bytes = small_cache_bytes("frame_cache.rtscene");
+    EXPECT_EQ(load_scene_cache("frame_cache.rtscene").camera.hsize, 100u);
+
+    // The camera's hsize and vsize follow the 40 byte start of the header
+    std::vector<std::array<uint32_t, 2>> sizes = {{0, 50}, {100, 0}, {100000, 1}, {40000, 40000}};
+    for (const std::array<uint32_t, 2> &size : sizes) {
+        std::vector<char> patched = bytes;
+        std::memcpy(patched.data() + 40, size.data(), 8);
+        write_cache_bytes(patched, "frame_cache.rtscene");
+        EXPECT_THROW(load_scene_cache("frame_cache.rtscene"), std::runtime_error) << size[0] << "x" << size[1];
+    }
+    std::remove("frame_cache.rtscene");
+}
+
+// Scenario: A cache whose BVH lists one shape twice and drops another is rejected
+// pMe
+TEST (TestSceneCache, RejectsRepeatedShapeIndex) {
+    std::vector<char> bytes = small_cache_bytes("index_cache.rtscene");
+    uint32_t counts[6];
+    std::memcpy(counts, bytes.data() + 12, sizeof(counts));
+    ASSERT_EQ(counts[1], 3u);
+    // The plane is unbounded, leaving two shapes in BVH leaf order
+    ASSERT_EQ(counts[4], 2u);
+    ASSERT_EQ(counts[5], 1u);
+    std::size_t indices_at = (8 + 8 * 4 + 19 * 4) + counts[1] * 41 * 4 + counts[2] * 6 * 4 + counts[3] * 9 * 4;
+    ASSERT_EQ(indices_at + 3 * 4, bytes.size());
+
+    uint32_t indices[3];
+    std::memcpy(indices, bytes.data() + indices_at, sizeof(indices));
+    std::vector<std::array<uint32_t, 3>> patches = {
+        {indices[0], indices[0], indices[2]},
+        {indices[0], indices[1], indices[0]},
+        {indices[0], indices[1], 3}
+    };
+    for (const std::array<uint32_t, 3> &patch : patches) {
+        std::vector<char> patched = bytes;
+        std::memcpy(patched.data() + indices_at, patch.data(), sizeof(indices));
+        write_cache_bytes(patched, "index_cache.rtscene");
+        EXPECT_THROW(load_scene_cache("index_cache.rtscene"), std::runtime_error);
+    }
+
+    // Swapping the BVH's two shapes is still one of each, so it loads
+    std::array<uint32_t, 3> swapped = {indices[1], indices[0], indices[2]};
+    std::memcpy(bytes.data() + indices_at, swapped.data(), sizeof(indices));
+    write_cache_bytes(bytes, "index_cache.rtscene");
+    EXPECT_TRUE(load_scene_cache("index_cache.rtscene").world.has_bvh());
+    std::remove("index_cache.rtscene");
+}
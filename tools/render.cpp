@@ -0,0 +1,74 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <exception>
+
+#include "ray_tracer.h"
+
+using namespace std::chrono;
+
+
+// Renders a scene file (see scene.h for the format) or a compiled scene
+// cache (see scene_cache.h) to a PNG or PPM image. With --compile, writes
+// the cache for a scene file instead. A supersampling grid size above 1
+// turns on adaptive anti-aliasing (see camera.h).
+int main(int argc, char **argv) {
+    if (argc == 4 && std::string(argv[1]) == "--compile") {
+        try {
+            Scene scene = load_scene(argv[2]);
+            write_scene_cache(scene.world, scene.camera, argv[3]);
+        } catch (const std::exception &e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        };
+        return 0;
+    };
+    if (argc < 3 || argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " <scene file or cache> <output.png|output.ppm> [threads [supersampling]]" << std::endl;
+        std::cerr << "       " << argv[0] << " --compile <scene file> <cache file>" << std::endl;
+        return 2;
+    };
+    std::string scene_file = argv[1];
+    std::string output = argv[2];
+    unsigned int threads = (argc >= 4) ? std::atoi(argv[3]) : std::thread::hardware_concurrency();
+    unsigned int supersampling = (argc == 5) ? std::atoi(argv[4]) : 1;
+
+    bool ppm = output.size() >= 4 && output.compare(output.size() - 4, 4, ".ppm") == 0;
+    bool png = output.size() >= 4 && output.compare(output.size() - 4, 4, ".png") == 0;
+    if (!ppm && !png) {
+        std::cerr << "The output file must end in .png or .ppm" << std::endl;
+        return 2;
+    };
+
+    try {
+        Scene scene = is_scene_cache(scene_file) ? load_scene_cache(scene_file) : load_scene(scene_file);
+        scene.camera.threads = std::max(threads, 1u);
+        scene.camera.supersampling = std::max(supersampling, 1u);
+
+        RenderStats stats;
+        auto start = high_resolution_clock::now();
+        Canvas image = scene.camera.render(scene.world, &stats);
+        auto stop = high_resolution_clock::now();
+
+        if (ppm) {
+            image.write_to_ppm(output, PPMFormat::P6);
+        } else {
+            image.write_to_png(output, scene.camera.threads);
+        };
+
+        auto duration = duration_cast<microseconds>(stop - start);
+        std::cout << "Rendered " << scene_file << " to " << output << " in "
+                  << duration.count() / 1000000.0 << " seconds." << std::endl;
+        if (scene.camera.supersampling > 1) {
+            std::cout << "Traced " << stats.samples << " camera rays, supersampling "
+                      << stats.supersampled_pixels << " of " << image.get_width() * image.get_height()
+                      << " pixels." << std::endl;
+        };
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    };
+    return 0;
+}